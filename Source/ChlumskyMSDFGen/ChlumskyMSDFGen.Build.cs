@@ -20,10 +20,12 @@ public class ChlumskyMSDFGen : ModuleRules
 				"ChlumskyMSDFGen/Public/Ext/",
 			});
 
+		// Public so that modules using the library see the move constructors of Shape, Contour and EdgeHolder as well
+		PublicDefinitions.Add("MSDFGEN_USE_CPP11");
+
 		PrivateDefinitions.AddRange(
 			new string[]
 			{
-				"MSDFGEN_USE_CPP11",
 				"_CRT_SECURE_NO_WARNINGS"
 			});
 
@@ -80,6 +80,36 @@ int Contour::winding() const {
     return sign(total);
 }
 
+double Contour::area() const {
+    // Green's theorem in closed form for each segment's control points
+    double total = 0;
+    for (std::vector<EdgeHolder>::const_iterator edge = edges.begin(); edge != edges.end(); ++edge) {
+        switch ((*edge)->type) {
+            case EdgeSegment::SegmentType::Linear:
+                {
+                    const Point2 *p = static_cast<const LinearSegment *>(&**edge)->p;
+                    total += 30*crossProduct(p[0], p[1]);
+                }
+                break;
+            case EdgeSegment::SegmentType::Quadratic:
+                {
+                    const Point2 *p = static_cast<const QuadraticSegment *>(&**edge)->p;
+                    total += 10*(2*crossProduct(p[0], p[1])+2*crossProduct(p[1], p[2])+crossProduct(p[0], p[2]));
+                }
+                break;
+            case EdgeSegment::SegmentType::Cubic:
+                {
+                    const Point2 *p = static_cast<const CubicSegment *>(&**edge)->p;
+                    total += 3*(6*crossProduct(p[0], p[1])+3*crossProduct(p[0], p[2])+crossProduct(p[0], p[3])+3*crossProduct(p[1], p[2])+3*crossProduct(p[1], p[3])+6*crossProduct(p[2], p[3]));
+                }
+                break;
+            default:;
+        }
+    }
+    // Negated to match the sign of winding
+    return -total/60;
+}
+
 void Contour::reverse() {
     for (int i = (int) edges.size()/2; i > 0; --i)
         EdgeHolder::swap(edges[i-1], edges[edges.size()-i]);
@@ -1,40 +1,54 @@
 
 #include "EdgeHolder.h"
 
+#include <new>
+
 namespace msdfgen {
 
 void EdgeHolder::swap(EdgeHolder &a, EdgeHolder &b) {
-    EdgeSegment *tmp = a.edgeSegment;
-    a.edgeSegment = b.edgeSegment;
-    b.edgeSegment = tmp;
+#ifdef MSDFGEN_USE_CPP11
+    EdgeHolder tmp((EdgeHolder &&) a);
+    a = (EdgeHolder &&) b;
+    b = (EdgeHolder &&) tmp;
+#else
+    EdgeHolder tmp(a);
+    a = b;
+    b = tmp;
+#endif
 }
 
 EdgeHolder::EdgeHolder() : edgeSegment(NULL) { }
 
-EdgeHolder::EdgeHolder(EdgeSegment *segment) : edgeSegment(segment) { }
+EdgeHolder::EdgeHolder(EdgeSegment *segment) : edgeSegment(NULL) {
+    assign(segment);
+    delete segment;
+}
 
-EdgeHolder::EdgeHolder(Point2 p0, Point2 p1, EdgeColor edgeColor) : edgeSegment(new LinearSegment(p0, p1, edgeColor)) { }
+EdgeHolder::EdgeHolder(Point2 p0, Point2 p1, EdgeColor edgeColor) : edgeSegment(new(&storage) LinearSegment(p0, p1, edgeColor)) { }
 
-EdgeHolder::EdgeHolder(Point2 p0, Point2 p1, Point2 p2, EdgeColor edgeColor) : edgeSegment(new QuadraticSegment(p0, p1, p2, edgeColor)) { }
+EdgeHolder::EdgeHolder(Point2 p0, Point2 p1, Point2 p2, EdgeColor edgeColor) : edgeSegment(new(&storage) QuadraticSegment(p0, p1, p2, edgeColor)) { }
 
-EdgeHolder::EdgeHolder(Point2 p0, Point2 p1, Point2 p2, Point2 p3, EdgeColor edgeColor) : edgeSegment(new CubicSegment(p0, p1, p2, p3, edgeColor)) { }
+EdgeHolder::EdgeHolder(Point2 p0, Point2 p1, Point2 p2, Point2 p3, EdgeColor edgeColor) : edgeSegment(new(&storage) CubicSegment(p0, p1, p2, p3, edgeColor)) { }
 
-EdgeHolder::EdgeHolder(const EdgeHolder &orig) : edgeSegment(orig.edgeSegment ? orig.edgeSegment->clone() : NULL) { }
+EdgeHolder::EdgeHolder(const EdgeHolder &orig) : edgeSegment(NULL) {
+    assign(orig.edgeSegment);
+}
 
 #ifdef MSDFGEN_USE_CPP11
-EdgeHolder::EdgeHolder(EdgeHolder &&orig) : edgeSegment(orig.edgeSegment) {
-    orig.edgeSegment = NULL;
+EdgeHolder::EdgeHolder(EdgeHolder &&orig) : edgeSegment(NULL) {
+    assign(orig.edgeSegment);
+    orig.clear();
 }
 #endif
 
 EdgeHolder::~EdgeHolder() {
-    delete edgeSegment;
+    clear();
 }
 
 EdgeHolder & EdgeHolder::operator=(const EdgeHolder &orig) {
     if (this != &orig) {
-        delete edgeSegment;
-        edgeSegment = orig.edgeSegment ? orig.edgeSegment->clone() : NULL;
+        clear();
+        assign(orig.edgeSegment);
     }
     return *this;
 }
@@ -42,9 +56,9 @@ EdgeHolder & EdgeHolder::operator=(const EdgeHolder &orig) {
 #ifdef MSDFGEN_USE_CPP11
 EdgeHolder & EdgeHolder::operator=(EdgeHolder &&orig) {
     if (this != &orig) {
-        delete edgeSegment;
-        edgeSegment = orig.edgeSegment;
-        orig.edgeSegment = NULL;
+        clear();
+        assign(orig.edgeSegment);
+        orig.clear();
     }
     return *this;
 }
@@ -74,4 +88,28 @@ EdgeHolder::operator const EdgeSegment *() const {
     return edgeSegment;
 }
 
+void EdgeHolder::assign(const EdgeSegment *segment) {
+    if (!segment)
+        return;
+    switch (segment->type) {
+        case EdgeSegment::SegmentType::Linear:
+            edgeSegment = new(&storage) LinearSegment(*static_cast<const LinearSegment *>(segment));
+            break;
+        case EdgeSegment::SegmentType::Quadratic:
+            edgeSegment = new(&storage) QuadraticSegment(*static_cast<const QuadraticSegment *>(segment));
+            break;
+        case EdgeSegment::SegmentType::Cubic:
+            edgeSegment = new(&storage) CubicSegment(*static_cast<const CubicSegment *>(segment));
+            break;
+        default:;
+    }
+}
+
+void EdgeHolder::clear() {
+    if (edgeSegment) {
+        edgeSegment->~EdgeSegment();
+        edgeSegment = NULL;
+    }
+}
+
 }
@@ -10,6 +10,7 @@
 #include "contour-combiners.h"
 #include "ShapeDistanceFinder.h"
 #include "generator-config.h"
+#include "Async/ParallelFor.h"
 
 THIRD_PARTY_INCLUDES_START
 
@@ -21,9 +22,28 @@ namespace msdfgen {
 #define CLASSIFIER_FLAG_CANDIDATE 0x01
 #define CLASSIFIER_FLAG_ARTIFACT 0x02
 
+#define ERROR_CORRECTION_BAND_HEIGHT 16
+#define ERROR_CORRECTION_TILE_SIZE 8
+#define STENCIL_WORD_BITS 64
+
 const double ErrorCorrectionConfig::defaultMinDeviationRatio = 1.11111111111111111;
 const double ErrorCorrectionConfig::defaultMinImproveRatio = 1.11111111111111111;
 
+size_t ErrorCorrectionConfig::bufferSize(int width, int height) {
+    return MSDFErrorCorrection::stencilBufferSize(width, height);
+}
+
+int ErrorCorrectionConfig::countErrors(const byte *buffer, int width, int height) {
+    // The error bitset comes first in the stencil buffer, its padding bits are never set.
+    const MSDFErrorCorrection::StencilWord *errorBits = reinterpret_cast<const MSDFErrorCorrection::StencilWord *>(buffer);
+    int wordCount = (width+STENCIL_WORD_BITS-1)/STENCIL_WORD_BITS*height;
+    int count = 0;
+    for (int i = 0; i < wordCount; ++i)
+        for (MSDFErrorCorrection::StencilWord word = errorBits[i]; word; word &= word-1)
+            ++count;
+    return count;
+}
+
 /// The base artifact classifier recognizes artifacts based on the contents of the SDF alone.
 class BaseArtifactClassifier {
 public:
@@ -49,6 +69,73 @@ private:
     bool protectedFlag;
 };
 
+/// An edge of the shape together with its neighbors in the contour, which delimit its pseudo-distance domain.
+struct ContourEdge {
+    const EdgeSegment *prevEdge, *edge, *nextEdge;
+};
+
+/// Lists the edges of the shape in the order in which the generator indexes them in ErrorCorrectionConfig::nearestEdgeBuffer.
+static void listContourEdges(std::vector<ContourEdge> &contourEdges, const Shape &shape) {
+    contourEdges.reserve(shape.edgeCount());
+    for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour) {
+        int edgeCount = (int) contour->edges.size();
+        for (int i = 0; i < edgeCount; ++i) {
+            ContourEdge contourEdge = { contour->edges[(i+edgeCount-1)%edgeCount], contour->edges[i], contour->edges[(i+1)%edgeCount] };
+            contourEdges.push_back(contourEdge);
+        }
+    }
+}
+
+/// Evaluates the pseudo-distance to the edges which the generator recorded as nearest to a texel and its 8 neighbors.
+/// The points tested by the artifact classifiers lie within this neighborhood, so this is a cheap substitute for the distance to the whole shape.
+class LocalEdgeDistanceFinder {
+public:
+    inline LocalEdgeDistanceFinder(const std::vector<ContourEdge> &contourEdges, const BitmapConstRef<int, 1> &nearestEdges) : contourEdges(contourEdges), nearestEdges(nearestEdges), x(0), row(0), candidateCount(0) { }
+    /// Sets the texel whose neighborhood is evaluated. Candidate edges are only gathered once they are needed.
+    inline void setTexel(int x, int row) {
+        this->x = x, this->row = row;
+        candidateCount = -1;
+    }
+    /// Returns true if any edges have been recorded for the current neighborhood.
+    inline bool hasCandidates() {
+        if (candidateCount < 0)
+            gatherCandidates();
+        return candidateCount > 0;
+    }
+    inline double distance(const Point2 &origin) const {
+        PseudoDistanceSelector edgeSelector;
+        edgeSelector.reset(origin);
+        for (int i = 0; i < candidateCount; ++i) {
+            const ContourEdge &contourEdge = contourEdges[candidates[i]];
+            PseudoDistanceSelector::EdgeCache dummy;
+            edgeSelector.addEdge(dummy, contourEdge.prevEdge, contourEdge.edge, contourEdge.nextEdge);
+        }
+        return edgeSelector.distance();
+    }
+private:
+    const std::vector<ContourEdge> &contourEdges;
+    BitmapConstRef<int, 1> nearestEdges;
+    int x, row;
+    int candidates[9];
+    int candidateCount;
+
+    void gatherCandidates() {
+        candidateCount = 0;
+        for (int ny = max(row-1, 0), yEnd = min(row+2, nearestEdges.height); ny < yEnd; ++ny) {
+            for (int nx = max(x-1, 0), xEnd = min(x+2, nearestEdges.width); nx < xEnd; ++nx) {
+                int edgeIndex = *nearestEdges(nx, ny);
+                if (edgeIndex < 0 || edgeIndex >= (int) contourEdges.size())
+                    continue;
+                bool duplicate = false;
+                for (int i = 0; i < candidateCount && !duplicate; ++i)
+                    duplicate = candidates[i] == edgeIndex;
+                if (!duplicate)
+                    candidates[candidateCount++] = edgeIndex;
+            }
+        }
+    }
+};
+
 /// The shape distance checker evaluates the exact shape distance to find additional artifacts at a significant performance cost.
 template <template <typename> class ContourCombiner, int N>
 class ShapeDistanceChecker {
@@ -76,7 +163,7 @@ public:
                 // Compute the evaluated distance (interpolated median) before and after error correction, as well as the exact shape distance.
                 float oldPSD = median(oldMSD[0], oldMSD[1], oldMSD[2]);
                 float newPSD = median(newMSD[0], newMSD[1], newMSD[2]);
-                float refPSD = float(parent->invRange*parent->distanceFinder.distance(parent->shapeCoord+tVector*parent->texelSize)+.5);
+                float refPSD = float(parent->invRange*parent->referenceDistance(parent->shapeCoord+tVector*parent->texelSize)+.5);
                 // Compare the differences of the exact distance and the before and after distances.
                 return parent->minImproveRatio*fabsf(newPSD-refPSD) < double(fabsf(oldPSD-refPSD));
             }
@@ -89,13 +176,21 @@ public:
     Point2 shapeCoord, sdfCoord;
     const float *msd;
     bool protectedFlag;
-    inline ShapeDistanceChecker(const BitmapConstRef<float, N> &sdf, const Shape &shape, const Projection &projection, double invRange, double minImproveRatio) : distanceFinder(shape), sdf(sdf), invRange(invRange), minImproveRatio(minImproveRatio) {
+    /// If set, the distance is only evaluated against the edges local to the current texel, unless none are known.
+    LocalEdgeDistanceFinder *localEdges;
+    inline ShapeDistanceChecker(const BitmapConstRef<float, N> &sdf, const Shape &shape, const Projection &projection, double invRange, double minImproveRatio) : localEdges(NULL), distanceFinder(shape), sdf(sdf), invRange(invRange), minImproveRatio(minImproveRatio) {
         texelSize = projection.unprojectVector(Vector2(1));
     }
     inline ArtifactClassifier classifier(const Vector2 &direction, double span) {
         return ArtifactClassifier(this, direction, span);
     }
 private:
+    inline double referenceDistance(const Point2 &point) {
+        if (localEdges && localEdges->hasCandidates())
+            return localEdges->distance(point);
+        return distanceFinder.distance(point);
+    }
+
     ShapeDistanceFinder<ContourCombiner<PseudoDistanceSelector> > distanceFinder;
     BitmapConstRef<float, N> sdf;
     double invRange;
@@ -103,13 +198,62 @@ private:
     double minImproveRatio;
 };
 
-MSDFErrorCorrection::MSDFErrorCorrection() { }
+/// Splits the rows of the distance field into bands, which are processed by worker threads in parallel.
+template <typename BandFunction>
+static void forEachRowBand(int height, const BandFunction &processBand) {
+    int bandCount = (height+ERROR_CORRECTION_BAND_HEIGHT-1)/ERROR_CORRECTION_BAND_HEIGHT;
+    ParallelFor(bandCount, [&](int32 band) {
+        int rowStart = band*ERROR_CORRECTION_BAND_HEIGHT;
+        processBand(rowStart, min(rowStart+ERROR_CORRECTION_BAND_HEIGHT, height));
+    });
+}
+
+/// Computes the medians of a row of texels. The loop has no data-dependent branches so that it can be vectorized.
+template <int N>
+static void computeMedians(float *medians, const float *texels, int count) {
+    for (int i = 0; i < count; ++i, texels += N)
+        medians[i] = median(texels[0], texels[1], texels[2]);
+}
+
+/// Texel medians of a band of rows, including a halo row above and below it, for evaluation of the 8-neighbor stencil.
+template <int N>
+class BandMedians {
+public:
+    inline BandMedians(const BitmapConstRef<float, N> &sdf, int rowStart, int rowEnd) : medians((rowEnd-rowStart+2)*sdf.width), rowStart(rowStart), width(sdf.width) {
+        for (int y = max(rowStart-1, 0), end = min(rowEnd+1, sdf.height); y < end; ++y)
+            computeMedians<N>(&medians[(y-rowStart+1)*width], sdf(0, y), width);
+    }
+    inline float operator()(int x, int y) const {
+        return medians[(y-rowStart+1)*width+x];
+    }
+private:
+    std::vector<float> medians;
+    int rowStart;
+    int width;
+};
+
+size_t MSDFErrorCorrection::stencilBufferSize(int width, int height) {
+    return 2*sizeof(StencilWord)*((width+STENCIL_WORD_BITS-1)/STENCIL_WORD_BITS)*height;
+}
+
+MSDFErrorCorrection::MSDFErrorCorrection() : errorBits(NULL), protectedBits(NULL), width(0), height(0), wordsPerRow(0), tileColumns(0) { }
 
-MSDFErrorCorrection::MSDFErrorCorrection(const BitmapRef<byte, 1> &stencil, const Projection &projection, double range) : stencil(stencil), projection(projection) {
+MSDFErrorCorrection::MSDFErrorCorrection(byte *stencilBuffer, int width, int height, const Projection &projection, double range) : width(width), height(height), projection(projection), tileColumns(0) {
     invRange = 1/range;
     minDeviationRatio = ErrorCorrectionConfig::defaultMinDeviationRatio;
     minImproveRatio = ErrorCorrectionConfig::defaultMinImproveRatio;
-    memset(stencil.pixels, 0, sizeof(byte)*stencil.width*stencil.height);
+    wordsPerRow = (width+STENCIL_WORD_BITS-1)/STENCIL_WORD_BITS;
+    errorBits = reinterpret_cast<StencilWord *>(stencilBuffer);
+    protectedBits = errorBits+wordsPerRow*height;
+    memset(stencilBuffer, 0, stencilBufferSize(width, height));
+}
+
+inline void MSDFErrorCorrection::setFlag(StencilWord *bits, int x, int y) {
+    bits[wordsPerRow*y+x/STENCIL_WORD_BITS] |= StencilWord(1)<<(x%STENCIL_WORD_BITS);
+}
+
+inline bool MSDFErrorCorrection::hasFlag(const StencilWord *bits, int x, int y) const {
+    return (bits[wordsPerRow*y+x/STENCIL_WORD_BITS]>>(x%STENCIL_WORD_BITS)&1) != 0;
 }
 
 void MSDFErrorCorrection::setMinDeviationRatio(double minDeviationRatio) {
@@ -120,6 +264,10 @@ void MSDFErrorCorrection::setMinImproveRatio(double minImproveRatio) {
     this->minImproveRatio = minImproveRatio;
 }
 
+void MSDFErrorCorrection::setNearestEdges(const BitmapConstRef<int, 1> &nearestEdges) {
+    this->nearestEdges = nearestEdges;
+}
+
 void MSDFErrorCorrection::protectCorners(const Shape &shape) {
     for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour)
         if (!contour->edges.empty()) {
@@ -131,21 +279,21 @@ void MSDFErrorCorrection::protectCorners(const Shape &shape) {
                     // Find the four texels that envelop the corner and mark them as protected.
                     Point2 p = projection.project((*edge)->point(0));
                     if (shape.inverseYAxis)
-                        p.y = stencil.height-p.y;
+                        p.y = height-p.y;
                     int l = (int) floor(p.x-.5);
                     int b = (int) floor(p.y-.5);
                     int r = l+1;
                     int t = b+1;
                     // Check that the positions are within bounds.
-                    if (l < stencil.width && b < stencil.height && r >= 0 && t >= 0) {
+                    if (l < width && b < height && r >= 0 && t >= 0) {
                         if (l >= 0 && b >= 0)
-                            *stencil(l, b) |= (byte) PROTECTED;
-                        if (r < stencil.width && b >= 0)
-                            *stencil(r, b) |= (byte) PROTECTED;
-                        if (l >= 0 && t < stencil.height)
-                            *stencil(l, t) |= (byte) PROTECTED;
-                        if (r < stencil.width && t < stencil.height)
-                            *stencil(r, t) |= (byte) PROTECTED;
+                            setFlag(protectedBits, l, b);
+                        if (r < width && b >= 0)
+                            setFlag(protectedBits, r, b);
+                        if (l >= 0 && t < height)
+                            setFlag(protectedBits, l, t);
+                        if (r < width && t < height)
+                            setFlag(protectedBits, r, t);
                     }
                 }
                 prevEdge = *edge;
@@ -179,82 +327,86 @@ static int edgeBetweenTexels(const float *a, const float *b) {
     );
 }
 
-/// Marks texel as protected if one of its non-median channels is present in the channel mask.
-static void protectExtremeChannels(byte *stencil, const float *msd, float m, int mask) {
-    if (
+/// Determines if one of the texel's non-median channels is present in the channel mask.
+static bool hasExtremeChannel(const float *msd, float m, int mask) {
+    return (
         (mask&RED && msd[0] != m) ||
         (mask&GREEN && msd[1] != m) ||
         (mask&BLUE && msd[2] != m)
-    )
-        *stencil |= (byte) MSDFErrorCorrection::PROTECTED;
+    );
+}
+
+/// Determines if texel c, which is one of the texels a, b, contributes to an edge between them with one of its extreme channels.
+static bool edgePairProtects(const float *a, const float *b, float am, float bm, float radius, const float *c, float cm) {
+    return fabsf(am-.5f)+fabsf(bm-.5f) < radius && hasExtremeChannel(c, cm, edgeBetweenTexels(a, b));
 }
 
 template <int N>
 void MSDFErrorCorrection::protectEdges(const BitmapConstRef<float, N> &sdf) {
-    float radius;
-    // Horizontal texel pairs
-    radius = float(PROTECTION_RADIUS_TOLERANCE*projection.unprojectVector(Vector2(invRange, 0)).length());
-    for (int y = 0; y < sdf.height; ++y) {
-        const float *left = sdf(0, y);
-        const float *right = sdf(1, y);
-        for (int x = 0; x < sdf.width-1; ++x) {
-            float lm = median(left[0], left[1], left[2]);
-            float rm = median(right[0], right[1], right[2]);
-            if (fabsf(lm-.5f)+fabsf(rm-.5f) < radius) {
-                int mask = edgeBetweenTexels(left, right);
-                protectExtremeChannels(stencil(x, y), left, lm, mask);
-                protectExtremeChannels(stencil(x+1, y), right, rm, mask);
-            }
-            left += N, right += N;
-        }
-    }
-    // Vertical texel pairs
-    radius = float(PROTECTION_RADIUS_TOLERANCE*projection.unprojectVector(Vector2(0, invRange)).length());
-    for (int y = 0; y < sdf.height-1; ++y) {
-        const float *bottom = sdf(0, y);
-        const float *top = sdf(0, y+1);
-        for (int x = 0; x < sdf.width; ++x) {
-            float bm = median(bottom[0], bottom[1], bottom[2]);
-            float tm = median(top[0], top[1], top[2]);
-            if (fabsf(bm-.5f)+fabsf(tm-.5f) < radius) {
-                int mask = edgeBetweenTexels(bottom, top);
-                protectExtremeChannels(stencil(x, y), bottom, bm, mask);
-                protectExtremeChannels(stencil(x, y+1), top, tm, mask);
-            }
-            bottom += N, top += N;
-        }
-    }
-    // Diagonal texel pairs
-    radius = float(PROTECTION_RADIUS_TOLERANCE*projection.unprojectVector(Vector2(invRange)).length());
-    for (int y = 0; y < sdf.height-1; ++y) {
-        const float *lb = sdf(0, y);
-        const float *rb = sdf(1, y);
-        const float *lt = sdf(0, y+1);
-        const float *rt = sdf(1, y+1);
-        for (int x = 0; x < sdf.width-1; ++x) {
-            float mlb = median(lb[0], lb[1], lb[2]);
-            float mrb = median(rb[0], rb[1], rb[2]);
-            float mlt = median(lt[0], lt[1], lt[2]);
-            float mrt = median(rt[0], rt[1], rt[2]);
-            if (fabsf(mlb-.5f)+fabsf(mrt-.5f) < radius) {
-                int mask = edgeBetweenTexels(lb, rt);
-                protectExtremeChannels(stencil(x, y), lb, mlb, mask);
-                protectExtremeChannels(stencil(x+1, y+1), rt, mrt, mask);
-            }
-            if (fabsf(mrb-.5f)+fabsf(mlt-.5f) < radius) {
-                int mask = edgeBetweenTexels(rb, lt);
-                protectExtremeChannels(stencil(x+1, y), rb, mrb, mask);
-                protectExtremeChannels(stencil(x, y+1), lt, mlt, mask);
+    float hRadius = float(PROTECTION_RADIUS_TOLERANCE*projection.unprojectVector(Vector2(invRange, 0)).length());
+    float vRadius = float(PROTECTION_RADIUS_TOLERANCE*projection.unprojectVector(Vector2(0, invRange)).length());
+    float dRadius = float(PROTECTION_RADIUS_TOLERANCE*projection.unprojectVector(Vector2(invRange)).length());
+    // Each texel is tested against every neighbor it forms a pair with and only ever flags itself, so that bands can be processed independently.
+    // Pairs are always evaluated in the same order (left-right, bottom-top, lb-rt, rb-lt) regardless of which of the two texels is being flagged.
+    forEachRowBand(sdf.height, [&](int rowStart, int rowEnd) {
+        BandMedians<N> medians(sdf, rowStart, rowEnd);
+        for (int y = rowStart; y < rowEnd; ++y) {
+            bool hasBottom = y > 0, hasTop = y < sdf.height-1;
+            for (int x = 0; x < sdf.width; ++x) {
+                bool hasLeft = x > 0, hasRight = x < sdf.width-1;
+                const float *c = sdf(x, y);
+                float cm = medians(x, y);
+                if (
+                    // Horizontal texel pairs
+                    (hasLeft && edgePairProtects(sdf(x-1, y), c, medians(x-1, y), cm, hRadius, c, cm)) ||
+                    (hasRight && edgePairProtects(c, sdf(x+1, y), cm, medians(x+1, y), hRadius, c, cm)) ||
+                    // Vertical texel pairs
+                    (hasBottom && edgePairProtects(sdf(x, y-1), c, medians(x, y-1), cm, vRadius, c, cm)) ||
+                    (hasTop && edgePairProtects(c, sdf(x, y+1), cm, medians(x, y+1), vRadius, c, cm)) ||
+                    // Diagonal texel pairs
+                    (hasLeft && hasBottom && edgePairProtects(sdf(x-1, y-1), c, medians(x-1, y-1), cm, dRadius, c, cm)) ||
+                    (hasRight && hasTop && edgePairProtects(c, sdf(x+1, y+1), cm, medians(x+1, y+1), dRadius, c, cm)) ||
+                    (hasRight && hasBottom && edgePairProtects(sdf(x+1, y-1), c, medians(x+1, y-1), cm, dRadius, c, cm)) ||
+                    (hasLeft && hasTop && edgePairProtects(c, sdf(x-1, y+1), cm, medians(x-1, y+1), dRadius, c, cm))
+                )
+                    setFlag(protectedBits, x, y);
             }
-            lb += N, rb += N, lt += N, rt += N;
         }
-    }
+    });
 }
 
 void MSDFErrorCorrection::protectAll() {
-    byte *end = stencil.pixels+stencil.width*stencil.height;
-    for (byte *mask = stencil.pixels; mask < end; ++mask)
-        *mask |= (byte) PROTECTED;
+    // Padding bits past the end of each row are set as well, they are never read.
+    memset(protectedBits, 0xff, sizeof(StencilWord)*wordsPerRow*height);
+}
+
+/// Determines if the texel would remain the same after being clamped to the 0-1 range, regardless of error correction.
+static bool isSettledTexel(const float *msd) {
+    float lo = min(min(msd[0], msd[1]), msd[2]);
+    float hi = max(max(msd[0], msd[1]), msd[2]);
+    return lo >= 1 || hi <= 0 || lo == hi;
+}
+
+template <int N>
+void MSDFErrorCorrection::classifyTiles(const BitmapConstRef<float, N> &sdf) {
+    tileColumns = (sdf.width+ERROR_CORRECTION_TILE_SIZE-1)/ERROR_CORRECTION_TILE_SIZE;
+    int tileRows = (sdf.height+ERROR_CORRECTION_TILE_SIZE-1)/ERROR_CORRECTION_TILE_SIZE;
+    settledTiles.assign(tileColumns*tileRows, (byte) 0);
+    ParallelFor(tileRows, [&](int32 tileRow) {
+        int rowStart = tileRow*ERROR_CORRECTION_TILE_SIZE, rowEnd = min(rowStart+ERROR_CORRECTION_TILE_SIZE, sdf.height);
+        for (int tileColumn = 0; tileColumn < tileColumns; ++tileColumn) {
+            int colStart = tileColumn*ERROR_CORRECTION_TILE_SIZE, colEnd = min(colStart+ERROR_CORRECTION_TILE_SIZE, sdf.width);
+            bool settled = true;
+            for (int y = rowStart; y < rowEnd && settled; ++y)
+                for (int x = colStart; x < colEnd && settled; ++x)
+                    settled = isSettledTexel(sdf(x, y));
+            settledTiles[tileRow*tileColumns+tileColumn] = (byte) settled;
+        }
+    });
+}
+
+inline bool MSDFErrorCorrection::isInSettledTile(int x, int y) const {
+    return tileColumns && settledTiles[(y/ERROR_CORRECTION_TILE_SIZE)*tileColumns+x/ERROR_CORRECTION_TILE_SIZE];
 }
 
 /// Returns the median of the linear interpolation of texels a, b at t.
@@ -338,8 +490,7 @@ static bool hasDiagonalArtifactInner(const ArtifactClassifier &artifactClassifie
 
 /// Checks if a linear interpolation artifact will occur inbetween two horizontally or vertically adjacent texels a, b.
 template <class ArtifactClassifier>
-static bool hasLinearArtifact(const ArtifactClassifier &artifactClassifier, float am, const float *a, const float *b) {
-    float bm = median(b[0], b[1], b[2]);
+static bool hasLinearArtifact(const ArtifactClassifier &artifactClassifier, float am, float bm, const float *a, const float *b) {
     return (
         // Out of the pair, only report artifacts for the texel further from the edge to minimize side effects.
         fabsf(am-.5f) >= fabsf(bm-.5f) && (
@@ -353,8 +504,7 @@ static bool hasLinearArtifact(const ArtifactClassifier &artifactClassifier, floa
 
 /// Checks if a bilinear interpolation artifact will occur inbetween two diagonally adjacent texels a, d (with b, c forming the other diagonal).
 template <class ArtifactClassifier>
-static bool hasDiagonalArtifact(const ArtifactClassifier &artifactClassifier, float am, const float *a, const float *b, const float *c, const float *d) {
-    float dm = median(d[0], d[1], d[2]);
+static bool hasDiagonalArtifact(const ArtifactClassifier &artifactClassifier, float am, float dm, const float *a, const float *b, const float *c, const float *d) {
     // Out of the pair, only report artifacts for the texel further from the edge to minimize side effects.
     if (fabsf(am-.5f) >= fabsf(dm-.5f)) {
         float abc[3] = {
@@ -396,26 +546,35 @@ void MSDFErrorCorrection::findErrors(const BitmapConstRef<float, N> &sdf) {
     double hSpan = minDeviationRatio*projection.unprojectVector(Vector2(invRange, 0)).length();
     double vSpan = minDeviationRatio*projection.unprojectVector(Vector2(0, invRange)).length();
     double dSpan = minDeviationRatio*projection.unprojectVector(Vector2(invRange)).length();
-    // Inspect all texels.
-    for (int y = 0; y < sdf.height; ++y) {
-        for (int x = 0; x < sdf.width; ++x) {
-            const float *c = sdf(x, y);
-            float cm = median(c[0], c[1], c[2]);
-            bool protectedFlag = (*stencil(x, y)&PROTECTED) != 0;
-            const float *l = NULL, *b = NULL, *r = NULL, *t = NULL;
-            // Mark current texel c with the error flag if an artifact occurs when it's interpolated with any of its 8 neighbors.
-            *stencil(x, y) |= (byte) (ERROR*(
-                (x > 0 && ((l = sdf(x-1, y)), hasLinearArtifact(BaseArtifactClassifier(hSpan, protectedFlag), cm, c, l))) ||
-                (y > 0 && ((b = sdf(x, y-1)), hasLinearArtifact(BaseArtifactClassifier(vSpan, protectedFlag), cm, c, b))) ||
-                (x < sdf.width-1 && ((r = sdf(x+1, y)), hasLinearArtifact(BaseArtifactClassifier(hSpan, protectedFlag), cm, c, r))) ||
-                (y < sdf.height-1 && ((t = sdf(x, y+1)), hasLinearArtifact(BaseArtifactClassifier(vSpan, protectedFlag), cm, c, t))) ||
-                (x > 0 && y > 0 && hasDiagonalArtifact(BaseArtifactClassifier(dSpan, protectedFlag), cm, c, l, b, sdf(x-1, y-1))) ||
-                (x < sdf.width-1 && y > 0 && hasDiagonalArtifact(BaseArtifactClassifier(dSpan, protectedFlag), cm, c, r, b, sdf(x+1, y-1))) ||
-                (x > 0 && y < sdf.height-1 && hasDiagonalArtifact(BaseArtifactClassifier(dSpan, protectedFlag), cm, c, l, t, sdf(x-1, y+1))) ||
-                (x < sdf.width-1 && y < sdf.height-1 && hasDiagonalArtifact(BaseArtifactClassifier(dSpan, protectedFlag), cm, c, r, t, sdf(x+1, y+1)))
-            ));
+    // Inspect all texels. Only the flags of the current texel are read and written, so bands are independent.
+    forEachRowBand(sdf.height, [&](int rowStart, int rowEnd) {
+        BandMedians<N> medians(sdf, rowStart, rowEnd);
+        for (int y = rowStart; y < rowEnd; ++y) {
+            bool hasBottom = y > 0, hasTop = y < sdf.height-1;
+            for (int x = 0; x < sdf.width; ++x) {
+                if (isInSettledTile(x, y))
+                    continue;
+                bool hasLeft = x > 0, hasRight = x < sdf.width-1;
+                const float *c = sdf(x, y);
+                float cm = medians(x, y);
+                bool protectedFlag = hasFlag(protectedBits, x, y);
+                const float *l = hasLeft ? sdf(x-1, y) : NULL, *b = hasBottom ? sdf(x, y-1) : NULL;
+                const float *r = hasRight ? sdf(x+1, y) : NULL, *t = hasTop ? sdf(x, y+1) : NULL;
+                // Mark current texel c with the error flag if an artifact occurs when it's interpolated with any of its 8 neighbors.
+                if ((
+                    (hasLeft && hasLinearArtifact(BaseArtifactClassifier(hSpan, protectedFlag), cm, medians(x-1, y), c, l)) ||
+                    (hasBottom && hasLinearArtifact(BaseArtifactClassifier(vSpan, protectedFlag), cm, medians(x, y-1), c, b)) ||
+                    (hasRight && hasLinearArtifact(BaseArtifactClassifier(hSpan, protectedFlag), cm, medians(x+1, y), c, r)) ||
+                    (hasTop && hasLinearArtifact(BaseArtifactClassifier(vSpan, protectedFlag), cm, medians(x, y+1), c, t)) ||
+                    (hasLeft && hasBottom && hasDiagonalArtifact(BaseArtifactClassifier(dSpan, protectedFlag), cm, medians(x-1, y-1), c, l, b, sdf(x-1, y-1))) ||
+                    (hasRight && hasBottom && hasDiagonalArtifact(BaseArtifactClassifier(dSpan, protectedFlag), cm, medians(x+1, y-1), c, r, b, sdf(x+1, y-1))) ||
+                    (hasLeft && hasTop && hasDiagonalArtifact(BaseArtifactClassifier(dSpan, protectedFlag), cm, medians(x-1, y+1), c, l, t, sdf(x-1, y+1))) ||
+                    (hasRight && hasTop && hasDiagonalArtifact(BaseArtifactClassifier(dSpan, protectedFlag), cm, medians(x+1, y+1), c, r, t, sdf(x+1, y+1)))
+                ))
+                    setFlag(errorBits, x, y);
+            }
         }
-    }
+    });
 }
 
 template <template <typename> class ContourCombiner, int N>
@@ -424,67 +583,80 @@ void MSDFErrorCorrection::findErrors(const BitmapConstRef<float, N> &sdf, const
     double hSpan = minDeviationRatio*projection.unprojectVector(Vector2(invRange, 0)).length();
     double vSpan = minDeviationRatio*projection.unprojectVector(Vector2(0, invRange)).length();
     double dSpan = minDeviationRatio*projection.unprojectVector(Vector2(invRange)).length();
-#ifdef MSDFGEN_USE_OPENMP
-    #pragma omp parallel
-#endif
-    {
+    std::vector<ContourEdge> contourEdges;
+    if (nearestEdges.pixels)
+        listContourEdges(contourEdges, shape);
+    forEachRowBand(sdf.height, [&](int rowStart, int rowEnd) {
         ShapeDistanceChecker<ContourCombiner, N> shapeDistanceChecker(sdf, shape, projection, invRange, minImproveRatio);
+        LocalEdgeDistanceFinder localEdges(contourEdges, nearestEdges);
+        if (nearestEdges.pixels)
+            shapeDistanceChecker.localEdges = &localEdges;
+        BandMedians<N> medians(sdf, rowStart, rowEnd);
         bool rightToLeft = false;
         // Inspect all texels.
-#ifdef MSDFGEN_USE_OPENMP
-        #pragma omp for
-#endif
-        for (int y = 0; y < sdf.height; ++y) {
-            int row = shape.inverseYAxis ? sdf.height-y-1 : y;
+        for (int row = rowStart; row < rowEnd; ++row) {
+            int y = shape.inverseYAxis ? sdf.height-row-1 : row;
+            bool hasBottom = row > 0, hasTop = row < sdf.height-1;
             for (int col = 0; col < sdf.width; ++col) {
                 int x = rightToLeft ? sdf.width-col-1 : col;
-                if ((*stencil(x, row)&ERROR))
+                if (hasFlag(errorBits, x, row) || isInSettledTile(x, row))
                     continue;
+                bool hasLeft = x > 0, hasRight = x < sdf.width-1;
                 const float *c = sdf(x, row);
                 shapeDistanceChecker.shapeCoord = projection.unproject(Point2(x+.5, y+.5));
                 shapeDistanceChecker.sdfCoord = Point2(x+.5, row+.5);
                 shapeDistanceChecker.msd = c;
-                shapeDistanceChecker.protectedFlag = (*stencil(x, row)&PROTECTED) != 0;
-                float cm = median(c[0], c[1], c[2]);
-                const float *l = NULL, *b = NULL, *r = NULL, *t = NULL;
+                shapeDistanceChecker.protectedFlag = hasFlag(protectedBits, x, row);
+                localEdges.setTexel(x, row);
+                float cm = medians(x, row);
+                const float *l = hasLeft ? sdf(x-1, row) : NULL, *b = hasBottom ? sdf(x, row-1) : NULL;
+                const float *r = hasRight ? sdf(x+1, row) : NULL, *t = hasTop ? sdf(x, row+1) : NULL;
                 // Mark current texel c with the error flag if an artifact occurs when it's interpolated with any of its 8 neighbors.
-                *stencil(x, row) |= (byte) (ERROR*(
-                    (x > 0 && ((l = sdf(x-1, row)), hasLinearArtifact(shapeDistanceChecker.classifier(Vector2(-1, 0), hSpan), cm, c, l))) ||
-                    (row > 0 && ((b = sdf(x, row-1)), hasLinearArtifact(shapeDistanceChecker.classifier(Vector2(0, -1), vSpan), cm, c, b))) ||
-                    (x < sdf.width-1 && ((r = sdf(x+1, row)), hasLinearArtifact(shapeDistanceChecker.classifier(Vector2(+1, 0), hSpan), cm, c, r))) ||
-                    (row < sdf.height-1 && ((t = sdf(x, row+1)), hasLinearArtifact(shapeDistanceChecker.classifier(Vector2(0, +1), vSpan), cm, c, t))) ||
-                    (x > 0 && row > 0 && hasDiagonalArtifact(shapeDistanceChecker.classifier(Vector2(-1, -1), dSpan), cm, c, l, b, sdf(x-1, row-1))) ||
-                    (x < sdf.width-1 && row > 0 && hasDiagonalArtifact(shapeDistanceChecker.classifier(Vector2(+1, -1), dSpan), cm, c, r, b, sdf(x+1, row-1))) ||
-                    (x > 0 && row < sdf.height-1 && hasDiagonalArtifact(shapeDistanceChecker.classifier(Vector2(-1, +1), dSpan), cm, c, l, t, sdf(x-1, row+1))) ||
-                    (x < sdf.width-1 && row < sdf.height-1 && hasDiagonalArtifact(shapeDistanceChecker.classifier(Vector2(+1, +1), dSpan), cm, c, r, t, sdf(x+1, row+1)))
-                ));
+                if ((
+                    (hasLeft && hasLinearArtifact(shapeDistanceChecker.classifier(Vector2(-1, 0), hSpan), cm, medians(x-1, row), c, l)) ||
+                    (hasBottom && hasLinearArtifact(shapeDistanceChecker.classifier(Vector2(0, -1), vSpan), cm, medians(x, row-1), c, b)) ||
+                    (hasRight && hasLinearArtifact(shapeDistanceChecker.classifier(Vector2(+1, 0), hSpan), cm, medians(x+1, row), c, r)) ||
+                    (hasTop && hasLinearArtifact(shapeDistanceChecker.classifier(Vector2(0, +1), vSpan), cm, medians(x, row+1), c, t)) ||
+                    (hasLeft && hasBottom && hasDiagonalArtifact(shapeDistanceChecker.classifier(Vector2(-1, -1), dSpan), cm, medians(x-1, row-1), c, l, b, sdf(x-1, row-1))) ||
+                    (hasRight && hasBottom && hasDiagonalArtifact(shapeDistanceChecker.classifier(Vector2(+1, -1), dSpan), cm, medians(x+1, row-1), c, r, b, sdf(x+1, row-1))) ||
+                    (hasLeft && hasTop && hasDiagonalArtifact(shapeDistanceChecker.classifier(Vector2(-1, +1), dSpan), cm, medians(x-1, row+1), c, l, t, sdf(x-1, row+1))) ||
+                    (hasRight && hasTop && hasDiagonalArtifact(shapeDistanceChecker.classifier(Vector2(+1, +1), dSpan), cm, medians(x+1, row+1), c, r, t, sdf(x+1, row+1)))
+                ))
+                    setFlag(errorBits, x, row);
             }
         }
-    }
+    });
 }
 
 template <int N>
 void MSDFErrorCorrection::apply(const BitmapRef<float, N> &sdf) const {
-    int texelCount = sdf.width*sdf.height;
-    const byte *mask = stencil.pixels;
-    float *texel = sdf.pixels;
-    for (int i = 0; i < texelCount; ++i) {
-        if (*mask&ERROR) {
-            // Set all color channels to the median.
-            float m = median(texel[0], texel[1], texel[2]);
-            texel[0] = m, texel[1] = m, texel[2] = m;
+    forEachRowBand(sdf.height, [&](int rowStart, int rowEnd) {
+        for (int y = rowStart; y < rowEnd; ++y) {
+            const StencilWord *errorRow = errorBits+wordsPerRow*y;
+            for (int word = 0; word < wordsPerRow; ++word) {
+                // Most words have no errors at all and are skipped as a whole.
+                StencilWord mask = errorRow[word];
+                for (int x = word*STENCIL_WORD_BITS; mask; mask >>= 1, ++x) {
+                    if (mask&1) {
+                        // Set all color channels to the median.
+                        float *texel = sdf(x, y);
+                        float m = median(texel[0], texel[1], texel[2]);
+                        texel[0] = m, texel[1] = m, texel[2] = m;
+                    }
+                }
+            }
         }
-        ++mask;
-        texel += N;
-    }
+    });
 }
 
-BitmapConstRef<byte, 1> MSDFErrorCorrection::getStencil() const {
-    return stencil;
+int MSDFErrorCorrection::getStencil(int x, int y) const {
+    return ERROR*hasFlag(errorBits, x, y)|PROTECTED*hasFlag(protectedBits, x, y);
 }
 
 template void MSDFErrorCorrection::protectEdges(const BitmapConstRef<float, 3> &sdf);
 template void MSDFErrorCorrection::protectEdges(const BitmapConstRef<float, 4> &sdf);
+template void MSDFErrorCorrection::classifyTiles(const BitmapConstRef<float, 3> &sdf);
+template void MSDFErrorCorrection::classifyTiles(const BitmapConstRef<float, 4> &sdf);
 template void MSDFErrorCorrection::findErrors(const BitmapConstRef<float, 3> &sdf);
 template void MSDFErrorCorrection::findErrors(const BitmapConstRef<float, 4> &sdf);
 template void MSDFErrorCorrection::findErrors<SimpleContourCombiner>(const BitmapConstRef<float, 3> &sdf, const Shape &shape);
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include "arithmetics.hpp"
+#include "Async/ParallelFor.h"
 
 namespace msdfgen {
 
@@ -59,12 +60,9 @@ static void deconvergeEdge(EdgeHolder &edgeHolder, int param) {
 void Shape::normalize() {
     for (std::vector<Contour>::iterator contour = contours.begin(); contour != contours.end(); ++contour) {
         if (contour->edges.size() == 1) {
-            EdgeSegment *parts[3] = { };
+            EdgeHolder parts[3];
             contour->edges[0]->splitInThirds(parts[0], parts[1], parts[2]);
-            contour->edges.clear();
-            contour->edges.push_back(EdgeHolder(parts[0]));
-            contour->edges.push_back(EdgeHolder(parts[1]));
-            contour->edges.push_back(EdgeHolder(parts[2]));
+            contour->edges.assign(parts, parts+3);
         } else {
             EdgeHolder *prevEdge = &contour->edges.back();
             for (std::vector<EdgeHolder>::iterator edge = contour->edges.begin(); edge != contour->edges.end(); ++edge) {
@@ -80,6 +78,80 @@ void Shape::normalize() {
     }
 }
 
+static int controlPoints(const EdgeSegment *edge, const Point2 *&points) {
+    switch (edge->type) {
+        case EdgeSegment::SegmentType::Linear:
+            points = static_cast<const LinearSegment *>(edge)->p;
+            return 2;
+        case EdgeSegment::SegmentType::Quadratic:
+            points = static_cast<const QuadraticSegment *>(edge)->p;
+            return 3;
+        case EdgeSegment::SegmentType::Cubic:
+            points = static_cast<const CubicSegment *>(edge)->p;
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+/// Returns the total area of the triangles between the contour's first point and each side of its edges' control polygons.
+/// Unlike the signed area, lobes wound in opposite directions don't cancel out, so it is only zero if every edge lies on a line through that point.
+static double controlPolygonCoverage(const Contour &contour) {
+    Point2 origin = contour.edges.front()->point(0);
+    double total = 0;
+    for (std::vector<EdgeHolder>::const_iterator edge = contour.edges.begin(); edge != contour.edges.end(); ++edge) {
+        const Point2 *p = NULL;
+        int n = controlPoints(*edge, p);
+        for (int i = 0; i+1 < n; ++i)
+            total += fabs(crossProduct(p[i]-origin, p[i+1]-origin));
+    }
+    return .5*total;
+}
+
+/// Returns whether edge b runs back along edge a.
+static bool isRetrace(const EdgeSegment *a, const EdgeSegment *b, double tolerance) {
+    const Point2 *p = NULL, *q = NULL;
+    int n = controlPoints(a, p);
+    if (controlPoints(b, q) != n)
+        return false;
+    for (int i = 0; i < n; ++i)
+        if ((p[i]-q[n-1-i]).length() > tolerance)
+            return false;
+    return true;
+}
+
+/// Returns whether every edge of the contour is retraced by another one, in the reverse order, so that the contour runs back along itself.
+static bool retracesItself(const Contour &contour, double tolerance) {
+    int n = (int) contour.edges.size();
+    for (int shift = 0; shift < n; ++shift) {
+        int i = 0;
+        while (i < n && isRetrace(contour.edges[i], contour.edges[((shift-i)%n+n)%n], tolerance))
+            ++i;
+        if (i == n)
+            return true;
+    }
+    return false;
+}
+
+int Shape::removeZeroAreaContours() {
+    int removedEdges = 0;
+    std::vector<Contour>::iterator kept = contours.begin();
+    for (std::vector<Contour>::iterator contour = contours.begin(); contour != contours.end(); ++contour) {
+        double l = +1e240, b = +1e240, r = -1e240, t = -1e240;
+        contour->bound(l, b, r, t);
+        double perimeter = 2*((r-l)+(t-b));
+        if (contour->edges.empty() || controlPolygonCoverage(*contour) <= MSDFGEN_ZERO_AREA_EPSILON*perimeter*perimeter || retracesItself(*contour, MSDFGEN_RETRACE_EPSILON*perimeter)) {
+            removedEdges += (int) contour->edges.size();
+            continue;
+        }
+        if (kept != contour)
+            *kept = (Contour &&) *contour;
+        ++kept;
+    }
+    contours.erase(kept, contours.end());
+    return removedEdges;
+}
+
 void Shape::bound(double &l, double &b, double &r, double &t) const {
     for (std::vector<Contour>::const_iterator contour = contours.begin(); contour != contours.end(); ++contour)
         contour->bound(l, b, r, t);
@@ -130,6 +202,34 @@ int Shape::edgeCount() const {
     return total;
 }
 
+// Unoriented contours cast their scanlines in parallel in blocks of this size, and the results are applied in contour order.
+#define MSDFGEN_ORIENT_CONTOURS_BLOCK_SIZE 256
+// Average number of contours per bucket of the vertical index used to find the contours a scanline may cross.
+#define MSDFGEN_ORIENT_CONTOURS_PER_BUCKET 4
+// Contours spanning more buckets than this are tested by every scanline instead of being added to each bucket.
+#define MSDFGEN_ORIENT_CONTOURS_MAX_BUCKET_SPAN 16
+
+static void verticalControlPointRange(const EdgeSegment *edge, double &bottom, double &top) {
+    const Point2 *p = NULL;
+    int n = 0;
+    switch (edge->type) {
+        case EdgeSegment::SegmentType::Linear:
+            p = static_cast<const LinearSegment *>(edge)->p, n = 2;
+            break;
+        case EdgeSegment::SegmentType::Quadratic:
+            p = static_cast<const QuadraticSegment *>(edge)->p, n = 3;
+            break;
+        case EdgeSegment::SegmentType::Cubic:
+            p = static_cast<const CubicSegment *>(edge)->p, n = 4;
+            break;
+        default:;
+    }
+    for (int i = 0; i < n; ++i) {
+        bottom = std::min(bottom, p[i].y);
+        top = std::max(top, p[i].y);
+    }
+}
+
 void Shape::orientContours() {
     struct Intersection {
         double x;
@@ -140,32 +240,86 @@ void Shape::orientContours() {
             return sign(reinterpret_cast<const Intersection *>(a)->x-reinterpret_cast<const Intersection *>(b)->x);
         }
     };
+    struct Vote {
+        int contourIndex;
+        int orientation;
+    };
 
+    static const double LARGE_VALUE = 1e240;
     const double ratio = .5*(sqrt(5)-1); // an irrational number to minimize chance of intersecting a corner or other point of interest
-    std::vector<int> orientations(contours.size());
-    std::vector<Intersection> intersections;
-    for (int i = 0; i < (int) contours.size(); ++i) {
-        if (!orientations[i] && !contours[i].edges.empty()) {
+    const int contourCount = (int) contours.size();
+
+    // Index contours by the vertical extent of their control points, which contains every point a scanline could intersect
+    std::vector<double> bottoms(contourCount, +LARGE_VALUE), tops(contourCount, -LARGE_VALUE);
+    double minY = +LARGE_VALUE, maxY = -LARGE_VALUE;
+    for (int i = 0; i < contourCount; ++i) {
+        for (std::vector<EdgeHolder>::const_iterator edge = contours[i].edges.begin(); edge != contours[i].edges.end(); ++edge)
+            verticalControlPointRange(*edge, bottoms[i], tops[i]);
+        if (!contours[i].edges.empty()) {
+            minY = std::min(minY, bottoms[i]);
+            maxY = std::max(maxY, tops[i]);
+        }
+    }
+    const int bucketCount = std::max(1, contourCount/MSDFGEN_ORIENT_CONTOURS_PER_BUCKET);
+    const double bucketScale = maxY > minY ? bucketCount/(maxY-minY) : 0;
+    std::vector<std::vector<int> > buckets(bucketCount);
+    std::vector<int> wideContours;
+    for (int i = 0; i < contourCount; ++i) {
+        if (contours[i].edges.empty())
+            continue;
+        int bucketBottom = std::min((int) (bucketScale*(bottoms[i]-minY)), bucketCount-1);
+        int bucketTop = std::min((int) (bucketScale*(tops[i]-minY)), bucketCount-1);
+        if (bucketTop-bucketBottom >= MSDFGEN_ORIENT_CONTOURS_MAX_BUCKET_SPAN)
+            wideContours.push_back(i);
+        else {
+            for (int b = bucketBottom; b <= bucketTop; ++b)
+                buckets[b].push_back(i);
+        }
+    }
+
+    std::vector<int> orientations(contourCount);
+    std::vector<int> pending;
+    std::vector<std::vector<Vote> > votes;
+    for (int blockStart = 0; blockStart < contourCount; blockStart += MSDFGEN_ORIENT_CONTOURS_BLOCK_SIZE) {
+        int blockEnd = std::min(blockStart+MSDFGEN_ORIENT_CONTOURS_BLOCK_SIZE, contourCount);
+        pending.clear();
+        for (int i = blockStart; i < blockEnd; ++i)
+            if (!orientations[i] && !contours[i].edges.empty())
+                pending.push_back(i);
+        votes.resize(pending.size());
+
+        ParallelFor((int32) pending.size(), [&](int32 k) {
+            const Contour &contour = contours[pending[k]];
             // Find an Y that crosses the contour
-            double y0 = contours[i].edges.front()->point(0).y;
+            double y0 = contour.edges.front()->point(0).y;
             double y1 = y0;
-            for (std::vector<EdgeHolder>::const_iterator edge = contours[i].edges.begin(); edge != contours[i].edges.end() && y0 == y1; ++edge)
+            for (std::vector<EdgeHolder>::const_iterator edge = contour.edges.begin(); edge != contour.edges.end() && y0 == y1; ++edge)
                 y1 = (*edge)->point(1).y;
-            for (std::vector<EdgeHolder>::const_iterator edge = contours[i].edges.begin(); edge != contours[i].edges.end() && y0 == y1; ++edge)
+            for (std::vector<EdgeHolder>::const_iterator edge = contour.edges.begin(); edge != contour.edges.end() && y0 == y1; ++edge)
                 y1 = (*edge)->point(ratio).y; // in case all endpoints are in a horizontal line
             double y = mix(y0, y1, ratio);
-            // Scanline through whole shape at Y
+            // Scanline through every contour that spans Y
+            std::vector<Intersection> intersections;
             double x[3];
             int dy[3];
-            for (int j = 0; j < (int) contours.size(); ++j) {
-                for (std::vector<EdgeHolder>::const_iterator edge = contours[j].edges.begin(); edge != contours[j].edges.end(); ++edge) {
-                    int n = (*edge)->scanlineIntersections(x, dy, y);
-                    for (int k = 0; k < n; ++k) {
-                        Intersection intersection = { x[k], dy[k], j };
-                        intersections.push_back(intersection);
+            const std::vector<int> &bucket = buckets[std::max(0, std::min((int) (bucketScale*(y-minY)), bucketCount-1))];
+            for (int list = 0; list < 2; ++list) {
+                const std::vector<int> &candidates = list ? wideContours : bucket;
+                for (std::vector<int>::const_iterator j = candidates.begin(); j != candidates.end(); ++j) {
+                    if (y < bottoms[*j] || y > tops[*j])
+                        continue;
+                    for (std::vector<EdgeHolder>::const_iterator edge = contours[*j].edges.begin(); edge != contours[*j].edges.end(); ++edge) {
+                        int n = (*edge)->scanlineIntersections(x, dy, y);
+                        for (int l = 0; l < n; ++l) {
+                            Intersection intersection = { x[l], dy[l], *j };
+                            intersections.push_back(intersection);
+                        }
                     }
                 }
             }
+            votes[k].clear();
+            if (intersections.empty())
+                return;
             qsort(&intersections[0], intersections.size(), sizeof(Intersection), &Intersection::compare);
             // Disqualify multiple intersections
             for (int j = 1; j < (int) intersections.size(); ++j)
@@ -173,13 +327,20 @@ void Shape::orientContours() {
                     intersections[j].direction = intersections[j-1].direction = 0;
             // Inspect scanline and deduce orientations of intersected contours
             for (int j = 0; j < (int) intersections.size(); ++j)
-                if (intersections[j].direction)
-                    orientations[intersections[j].contourIndex] += 2*((j&1)^(intersections[j].direction > 0))-1;
-            intersections.clear();
-        }
+                if (intersections[j].direction) {
+                    Vote vote = { intersections[j].contourIndex, 2*((j&1)^(intersections[j].direction > 0))-1 };
+                    votes[k].push_back(vote);
+                }
+        }, EParallelForFlags::Unbalanced);
+
+        // A contour already oriented by an earlier scanline of the block discards its own, exactly as if the scanlines had been cast one by one
+        for (int k = 0; k < (int) pending.size(); ++k)
+            if (!orientations[pending[k]])
+                for (std::vector<Vote>::const_iterator vote = votes[k].begin(); vote != votes[k].end(); ++vote)
+                    orientations[vote->contourIndex] += vote->orientation;
     }
     // Reverse contours that have the opposite orientation
-    for (int i = 0; i < (int) contours.size(); ++i)
+    for (int i = 0; i < contourCount; ++i)
         if (orientations[i] < 0)
             contours[i].reverse();
 }
@@ -0,0 +1,28 @@
+
+#include "SharedShape.h"
+
+namespace msdfgen {
+
+SharedShape::SharedShape() { }
+
+SharedShape::SharedShape(const Shape &shape) : shape(std::make_shared<const Shape>(shape)) { }
+
+SharedShape::SharedShape(Shape &&shape) : shape(std::make_shared<const Shape>((Shape &&) shape)) { }
+
+const Shape & SharedShape::operator*() const {
+    return *shape;
+}
+
+const Shape * SharedShape::operator->() const {
+    return shape.get();
+}
+
+SharedShape::operator const Shape *() const {
+    return shape.get();
+}
+
+long SharedShape::useCount() const {
+    return shape.use_count();
+}
+
+}
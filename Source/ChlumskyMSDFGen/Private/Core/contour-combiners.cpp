@@ -43,6 +43,11 @@ typename SimpleContourCombiner<EdgeSelector>::DistanceType SimpleContourCombiner
     return shapeEdgeSelector.distance();
 }
 
+template <class EdgeSelector>
+const EdgeSegment * SimpleContourCombiner<EdgeSelector>::nearestEdge() const {
+    return shapeEdgeSelector.nearestEdge();
+}
+
 template class SimpleContourCombiner<TrueDistanceSelector>;
 template class SimpleContourCombiner<PseudoDistanceSelector>;
 template class SimpleContourCombiner<MultiDistanceSelector>;
@@ -127,6 +132,19 @@ typename OverlappingContourCombiner<EdgeSelector>::DistanceType OverlappingConto
     return distance;
 }
 
+template <class EdgeSelector>
+const EdgeSegment * OverlappingContourCombiner<EdgeSelector>::nearestEdge() const {
+    const EdgeSegment *edge = NULL;
+    SignedDistance minDistance;
+    for (typename std::vector<EdgeSelector>::const_iterator contourEdgeSelector = edgeSelectors.begin(); contourEdgeSelector != edgeSelectors.end(); ++contourEdgeSelector) {
+        if (contourEdgeSelector->trueDistance() < minDistance) {
+            minDistance = contourEdgeSelector->trueDistance();
+            edge = contourEdgeSelector->nearestEdge();
+        }
+    }
+    return edge;
+}
+
 template class OverlappingContourCombiner<TrueDistanceSelector>;
 template class OverlappingContourCombiner<PseudoDistanceSelector>;
 template class OverlappingContourCombiner<MultiDistanceSelector>;
@@ -6,6 +6,7 @@
 #include <cstring>
 #include <queue>
 #include "arithmetics.hpp"
+#include "Async/ParallelFor.h"
 
 
 THIRD_PARTY_INCLUDES_START
@@ -75,7 +76,7 @@ void edgeColoringSimple(Shape &shape, double angleThreshold, unsigned long long
                     contour->edges[(corner+i)%m]->color = (colors+1)[int(3+2.875*i/(m-1)-1.4375+.5)-3];
             } else if (contour->edges.size() >= 1) {
                 // Less than three edge segments for three colors => edges must be split
-                EdgeSegment *parts[7] = { };
+                EdgeHolder parts[6];
                 contour->edges[0]->splitInThirds(parts[0+3*corner], parts[1+3*corner], parts[2+3*corner]);
                 if (contour->edges.size() >= 2) {
                     contour->edges[1]->splitInThirds(parts[3-3*corner], parts[4-3*corner], parts[5-3*corner]);
@@ -87,9 +88,7 @@ void edgeColoringSimple(Shape &shape, double angleThreshold, unsigned long long
                     parts[1]->color = colors[1];
                     parts[2]->color = colors[2];
                 }
-                contour->edges.clear();
-                for (int i = 0; parts[i]; ++i)
-                    contour->edges.push_back(EdgeHolder(parts[i]));
+                contour->edges.assign(parts, parts+3*contour->edges.size());
             }
         }
         // Multiple corners
@@ -158,7 +157,7 @@ void edgeColoringInkTrap(Shape &shape, double angleThreshold, unsigned long long
                     contour->edges[(corner+i)%m]->color = (colors+1)[int(3+2.875*i/(m-1)-1.4375+.5)-3];
             } else if (contour->edges.size() >= 1) {
                 // Less than three edge segments for three colors => edges must be split
-                EdgeSegment *parts[7] = { };
+                EdgeHolder parts[6];
                 contour->edges[0]->splitInThirds(parts[0+3*corner], parts[1+3*corner], parts[2+3*corner]);
                 if (contour->edges.size() >= 2) {
                     contour->edges[1]->splitInThirds(parts[3-3*corner], parts[4-3*corner], parts[5-3*corner]);
@@ -170,9 +169,7 @@ void edgeColoringInkTrap(Shape &shape, double angleThreshold, unsigned long long
                     parts[1]->color = colors[1];
                     parts[2]->color = colors[2];
                 }
-                contour->edges.clear();
-                for (int i = 0; parts[i]; ++i)
-                    contour->edges.push_back(EdgeHolder(parts[i]));
+                contour->edges.assign(parts, parts+3*contour->edges.size());
             }
         }
         // Multiple corners
@@ -226,40 +223,135 @@ void edgeColoringInkTrap(Shape &shape, double angleThreshold, unsigned long long
 // EDGE COLORING BY DISTANCE - EXPERIMENTAL IMPLEMENTATION - WORK IN PROGRESS
 #define MAX_RECOLOR_STEPS 16
 #define EDGE_DISTANCE_PRECISION 16
+// Relative and absolute slack for the bounding box distance to absorb rounding errors, so that it never exceeds the sampled distance of the edges.
+#define EDGE_BOUNDS_TOLERANCE 1e-9
+
+/// Returns the distance between two bounding boxes - a lower bound of the distance between any points within them.
+static double boundsDistance(const Shape::Bounds &a, const Shape::Bounds &b) {
+    double dx = max(0., max(a.l-b.r, b.l-a.r));
+    double dy = max(0., max(a.b-b.t, b.b-a.t));
+    return sqrt(dx*dx+dy*dy);
+}
 
-static double edgeToEdgeDistance(const EdgeSegment &a, const EdgeSegment &b, int precision) {
-    if (a.point(0) == b.point(0) || a.point(0) == b.point(1) || a.point(1) == b.point(0) || a.point(1) == b.point(1))
-        return 0;
+/// Determines if a lower bound of a distance is too large to improve on minDistance, with a margin for rounding errors.
+static bool exceedsDistance(double lowerBound, double minDistance) {
+    return lowerBound > (1+EDGE_BOUNDS_TOLERANCE)*minDistance+EDGE_BOUNDS_TOLERANCE;
+}
+
+/// Lowers minDistance to the distances between edge and points sampled along other. Points farther from the bounding box of edge than minDistance are not evaluated.
+static void sampleEdgeDistance(double &minDistance, const EdgeSegment &edge, const Shape::Bounds &edgeBounds, const EdgeSegment &other, int precision) {
     double iFac = 1./precision;
-    double minDistance = (b.point(0)-a.point(0)).length();
     for (int i = 0; i <= precision; ++i) {
         double t = iFac*i;
-        double d = fabs(a.signedDistance(b.point(t), t).distance);
-        minDistance = min(minDistance, d);
-    }
-    for (int i = 0; i <= precision; ++i) {
-        double t = iFac*i;
-        double d = fabs(b.signedDistance(a.point(t), t).distance);
+        Point2 p = other.point(t);
+        double dx = max(0., max(edgeBounds.l-p.x, p.x-edgeBounds.r));
+        double dy = max(0., max(edgeBounds.b-p.y, p.y-edgeBounds.t));
+        if (exceedsDistance(sqrt(dx*dx+dy*dy), minDistance))
+            continue;
+        double d = fabs(edge.signedDistance(p, t).distance);
         minDistance = min(minDistance, d);
     }
+}
+
+static double edgeToEdgeDistance(const EdgeSegment &a, const Shape::Bounds &aBounds, const EdgeSegment &b, const Shape::Bounds &bBounds, int precision) {
+    if (a.point(0) == b.point(0) || a.point(0) == b.point(1) || a.point(1) == b.point(0) || a.point(1) == b.point(1))
+        return 0;
+    double minDistance = (b.point(0)-a.point(0)).length();
+    sampleEdgeDistance(minDistance, a, aBounds, b, precision);
+    sampleEdgeDistance(minDistance, b, bBounds, a, precision);
     return minDistance;
 }
 
-static double splineToSplineDistance(EdgeSegment * const *edgeSegments, int aStart, int aEnd, int bStart, int bEnd, int precision) {
-    double minDistance = fabs(SignedDistance::INFINITE.distance);
+/// Every distance sampled by edgeToEdgeDistance is between points of the two edges, so edge pairs whose bounding boxes are farther apart than the nearest pair found so far cannot affect the result.
+static double splineToSplineDistance(EdgeSegment * const *edgeSegments, const Shape::Bounds *edgeBounds, int aStart, int aEnd, int bStart, int bEnd, int precision) {
+    // Start with the pair of edges with the nearest bounding boxes to prune as many of the remaining pairs as possible.
+    int nearestA = aStart, nearestB = bStart;
+    double nearestBoundsDistance = boundsDistance(edgeBounds[aStart], edgeBounds[bStart]);
     for (int ai = aStart; ai < aEnd; ++ai)
+        for (int bi = bStart; bi < bEnd; ++bi) {
+            double d = boundsDistance(edgeBounds[ai], edgeBounds[bi]);
+            if (d < nearestBoundsDistance) {
+                nearestA = ai, nearestB = bi;
+                nearestBoundsDistance = d;
+            }
+        }
+    double minDistance = edgeToEdgeDistance(*edgeSegments[nearestA], edgeBounds[nearestA], *edgeSegments[nearestB], edgeBounds[nearestB], precision);
+    for (int ai = aStart; ai < aEnd && minDistance; ++ai)
         for (int bi = bStart; bi < bEnd && minDistance; ++bi) {
-            double d = edgeToEdgeDistance(*edgeSegments[ai], *edgeSegments[bi], precision);
+            if ((ai == nearestA && bi == nearestB) || exceedsDistance(boundsDistance(edgeBounds[ai], edgeBounds[bi]), minDistance))
+                continue;
+            double d = edgeToEdgeDistance(*edgeSegments[ai], edgeBounds[ai], *edgeSegments[bi], edgeBounds[bi], precision);
             minDistance = min(minDistance, d);
         }
     return minDistance;
 }
 
-static void colorSecondDegreeGraph(int *coloring, const int * const *edgeMatrix, int vertexCount, unsigned long long seed) {
-    for (int i = 0; i < vertexCount; ++i) {
+typedef unsigned long long GraphWord;
+#define GRAPH_WORD_BITS 64
+
+/// Returns the index of the lowest set bit of a nonzero word.
+static int lowestBit(GraphWord word) {
+    static const int DE_BRUIJN_INDEX[64] = {
+        0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+        62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+        63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+        46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6
+    };
+    return DE_BRUIJN_INDEX[((word&(~word+1))*0x03f79d71b4cb0a89ull)>>58];
+}
+
+/// Adjacency matrix of the spline graph with each row stored as a bitset.
+class SplineGraph {
+public:
+    int vertexCount, words;
+    inline explicit SplineGraph(int vertexCount) : vertexCount(vertexCount), words((vertexCount+GRAPH_WORD_BITS-1)/GRAPH_WORD_BITS), matrix(words*vertexCount) { }
+    inline const GraphWord * row(int vertex) const {
+        return &matrix[words*vertex];
+    }
+    inline bool hasEdge(int a, int b) const {
+        return (row(a)[b/GRAPH_WORD_BITS]>>(b%GRAPH_WORD_BITS)&1) != 0;
+    }
+    inline void setEdge(int a, int b, bool present) {
+        setBit(&matrix[words*a], b, present);
+        setBit(&matrix[words*b], a, present);
+    }
+private:
+    std::vector<GraphWord> matrix;
+    static inline void setBit(GraphWord *bits, int index, bool value) {
+        GraphWord mask = GraphWord(1)<<(index%GRAPH_WORD_BITS);
+        bits[index/GRAPH_WORD_BITS] = value ? bits[index/GRAPH_WORD_BITS]|mask : bits[index/GRAPH_WORD_BITS]&~mask;
+    }
+};
+
+/// Colors of the vertices (0-2, or -1 if uncolored) along with a bitset of the vertices of each color, so that the colors of a vertex's neighbors can be gathered a word at a time.
+class GraphColoring {
+public:
+    inline explicit GraphColoring(int vertexCount) : words((vertexCount+GRAPH_WORD_BITS-1)/GRAPH_WORD_BITS), colors(vertexCount, -1), colorSets(3*words) { }
+    inline int operator[](int vertex) const {
+        return colors[vertex];
+    }
+    inline void set(int vertex, int color) {
+        GraphWord mask = GraphWord(1)<<(vertex%GRAPH_WORD_BITS);
+        if (colors[vertex] >= 0)
+            colorSets[words*colors[vertex]+vertex/GRAPH_WORD_BITS] &= ~mask;
+        if (color >= 0)
+            colorSets[words*color+vertex/GRAPH_WORD_BITS] |= mask;
+        colors[vertex] = color;
+    }
+    inline const GraphWord * colorSet(int color) const {
+        return &colorSets[words*color];
+    }
+private:
+    int words;
+    std::vector<int> colors;
+    std::vector<GraphWord> colorSets;
+};
+
+static void colorSecondDegreeGraph(GraphColoring &coloring, const SplineGraph &graph, unsigned long long seed) {
+    for (int i = 0; i < graph.vertexCount; ++i) {
         int possibleColors = 7;
         for (int j = 0; j < i; ++j) {
-            if (edgeMatrix[i][j])
+            if (graph.hasEdge(i, j))
                 possibleColors &= ~(1<<coloring[j]);
         }
         int color = 0;
@@ -290,71 +382,84 @@ static void colorSecondDegreeGraph(int *coloring, const int * const *edgeMatrix,
                 seed /= 3;
                 break;
         }
-        coloring[i] = color;
+        coloring.set(i, color);
     }
 }
 
-static int vertexPossibleColors(const int *coloring, const int *edgeVector, int vertexCount) {
+static int vertexPossibleColors(const GraphColoring &coloring, const SplineGraph &graph, int vertex) {
+    const GraphWord *neighbors = graph.row(vertex);
     int usedColors = 0;
-    for (int i = 0; i < vertexCount; ++i)
-        if (edgeVector[i])
-            usedColors |= 1<<coloring[i];
+    for (int color = 0; color < 3; ++color) {
+        const GraphWord *colorSet = coloring.colorSet(color);
+        for (int i = 0; i < graph.words; ++i)
+            if (neighbors[i]&colorSet[i]) {
+                usedColors |= 1<<color;
+                break;
+            }
+    }
     return 7&~usedColors;
 }
 
-static void uncolorSameNeighbors(std::queue<int> &uncolored, int *coloring, const int * const *edgeMatrix, int vertex, int vertexCount) {
-    for (int i = vertex+1; i < vertexCount; ++i) {
-        if (edgeMatrix[vertex][i] && coloring[i] == coloring[vertex]) {
-            coloring[i] = -1;
-            uncolored.push(i);
-        }
-    }
-    for (int i = 0; i < vertex; ++i) {
-        if (edgeMatrix[vertex][i] && coloring[i] == coloring[vertex]) {
-            coloring[i] = -1;
+/// Uncolors the neighbors of vertex with the same color as vertex between vertices start and end, and queues them in ascending order.
+static void uncolorSameNeighbors(std::queue<int> &uncolored, GraphColoring &coloring, const SplineGraph &graph, int vertex, int start, int end) {
+    const GraphWord *neighbors = graph.row(vertex);
+    const GraphWord *sameColor = coloring.colorSet(coloring[vertex]);
+    for (int word = start/GRAPH_WORD_BITS; word*GRAPH_WORD_BITS < end; ++word) {
+        GraphWord candidates = neighbors[word]&sameColor[word];
+        while (candidates) {
+            int i = word*GRAPH_WORD_BITS+lowestBit(candidates);
+            candidates &= candidates-1;
+            if (i < start)
+                continue;
+            if (i >= end)
+                break;
+            coloring.set(i, -1);
             uncolored.push(i);
         }
     }
 }
 
-static bool tryAddEdge(int *coloring, int * const *edgeMatrix, int vertexCount, int vertexA, int vertexB, int *coloringBuffer) {
+static void uncolorSameNeighbors(std::queue<int> &uncolored, GraphColoring &coloring, const SplineGraph &graph, int vertex) {
+    uncolorSameNeighbors(uncolored, coloring, graph, vertex, vertex+1, graph.vertexCount);
+    uncolorSameNeighbors(uncolored, coloring, graph, vertex, 0, vertex);
+}
+
+static bool tryAddEdge(GraphColoring &coloring, SplineGraph &graph, int vertexA, int vertexB, GraphColoring &coloringBuffer) {
     static const int FIRST_POSSIBLE_COLOR[8] = { -1, 0, 1, 0, 2, 2, 1, 0 };
-    edgeMatrix[vertexA][vertexB] = 1;
-    edgeMatrix[vertexB][vertexA] = 1;
+    graph.setEdge(vertexA, vertexB, true);
     if (coloring[vertexA] != coloring[vertexB])
         return true;
-    int bPossibleColors = vertexPossibleColors(coloring, edgeMatrix[vertexB], vertexCount);
+    int bPossibleColors = vertexPossibleColors(coloring, graph, vertexB);
     if (bPossibleColors) {
-        coloring[vertexB] = FIRST_POSSIBLE_COLOR[bPossibleColors];
+        coloring.set(vertexB, FIRST_POSSIBLE_COLOR[bPossibleColors]);
         return true;
     }
-    memcpy(coloringBuffer, coloring, sizeof(int)*vertexCount);
+    coloringBuffer = coloring;
     std::queue<int> uncolored;
     {
-        int *coloring = coloringBuffer;
-        coloring[vertexB] = FIRST_POSSIBLE_COLOR[7&~(1<<coloring[vertexA])];
-        uncolorSameNeighbors(uncolored, coloring, edgeMatrix, vertexB, vertexCount);
+        GraphColoring &coloring = coloringBuffer;
+        coloring.set(vertexB, FIRST_POSSIBLE_COLOR[7&~(1<<coloring[vertexA])]);
+        uncolorSameNeighbors(uncolored, coloring, graph, vertexB);
         int step = 0;
         while (!uncolored.empty() && step < MAX_RECOLOR_STEPS) {
             int i = uncolored.front();
             uncolored.pop();
-            int possibleColors = vertexPossibleColors(coloring, edgeMatrix[i], vertexCount);
+            int possibleColors = vertexPossibleColors(coloring, graph, i);
             if (possibleColors) {
-                coloring[i] = FIRST_POSSIBLE_COLOR[possibleColors];
+                coloring.set(i, FIRST_POSSIBLE_COLOR[possibleColors]);
                 continue;
             }
             do {
-                coloring[i] = step++%3;
-            } while (edgeMatrix[i][vertexA] && coloring[i] == coloring[vertexA]);
-            uncolorSameNeighbors(uncolored, coloring, edgeMatrix, i, vertexCount);
+                coloring.set(i, step++%3);
+            } while (graph.hasEdge(i, vertexA) && coloring[i] == coloring[vertexA]);
+            uncolorSameNeighbors(uncolored, coloring, graph, i);
         }
     }
     if (!uncolored.empty()) {
-        edgeMatrix[vertexA][vertexB] = 0;
-        edgeMatrix[vertexB][vertexA] = 0;
+        graph.setEdge(vertexA, vertexB, false);
         return false;
     }
-    memcpy(coloring, coloringBuffer, sizeof(int)*vertexCount);
+    std::swap(coloring, coloringBuffer);
     return true;
 }
 
@@ -401,25 +506,26 @@ void edgeColoringByDistance(Shape &shape, double angleThreshold, unsigned long l
                     }
                 } else if (contour->edges.size() >= 1) {
                     // Less than three edge segments for three colors => edges must be split
-                    EdgeSegment *parts[7] = { };
+                    EdgeHolder parts[6];
                     contour->edges[0]->splitInThirds(parts[0+3*corner], parts[1+3*corner], parts[2+3*corner]);
-                    if (contour->edges.size() >= 2) {
+                    if (contour->edges.size() >= 2)
                         contour->edges[1]->splitInThirds(parts[3-3*corner], parts[4-3*corner], parts[5-3*corner]);
-                        edgeSegments.push_back(parts[0]);
-                        edgeSegments.push_back(parts[1]);
-                        parts[2]->color = parts[3]->color = WHITE;
+                    contour->edges.assign(parts, parts+3*contour->edges.size());
+                    // Edges are stored inline, so the parts are only referenced once they are in their final place
+                    std::vector<EdgeHolder> &edges = contour->edges;
+                    if (edges.size() == 6) {
+                        edgeSegments.push_back(&*edges[0]);
+                        edgeSegments.push_back(&*edges[1]);
+                        edges[2]->color = edges[3]->color = WHITE;
                         splineStarts.push_back((int) edgeSegments.size());
-                        edgeSegments.push_back(parts[4]);
-                        edgeSegments.push_back(parts[5]);
+                        edgeSegments.push_back(&*edges[4]);
+                        edgeSegments.push_back(&*edges[5]);
                     } else {
-                        edgeSegments.push_back(parts[0]);
-                        parts[1]->color = WHITE;
+                        edgeSegments.push_back(&*edges[0]);
+                        edges[1]->color = WHITE;
                         splineStarts.push_back((int) edgeSegments.size());
-                        edgeSegments.push_back(parts[2]);
+                        edgeSegments.push_back(&*edges[2]);
                     }
-                    contour->edges.clear();
-                    for (int i = 0; parts[i]; ++i)
-                        contour->edges.push_back(EdgeHolder(parts[i]));
                 }
             }
             // Multiple corners
@@ -451,14 +557,23 @@ void edgeColoringByDistance(Shape &shape, double angleThreshold, unsigned long l
         distanceMatrix[i] = &distanceMatrixStorage[i*splineCount];
     const double *distanceMatrixBase = &distanceMatrixStorage[0];
 
-    for (int i = 0; i < splineCount; ++i) {
+    std::vector<Shape::Bounds> edgeBounds(segmentCount);
+    for (int i = 0; i < segmentCount; ++i) {
+        Shape::Bounds &bounds = edgeBounds[i];
+        bounds.l = bounds.b = fabs(SignedDistance::INFINITE.distance);
+        bounds.r = bounds.t = -fabs(SignedDistance::INFINITE.distance);
+        edgeSegments[i]->bound(bounds.l, bounds.b, bounds.r, bounds.t);
+    }
+
+    // Each row of the upper triangle writes only its own pairs, so rows can be processed in parallel. Rows get shorter towards the end, hence Unbalanced.
+    ParallelFor(splineCount, [&](int32 i) {
         distanceMatrix[i][i] = -1;
         for (int j = i+1; j < splineCount; ++j) {
-            double dist = splineToSplineDistance(&edgeSegments[0], splineStarts[i], splineStarts[i+1], splineStarts[j], splineStarts[j+1], EDGE_DISTANCE_PRECISION);
+            double dist = splineToSplineDistance(&edgeSegments[0], &edgeBounds[0], splineStarts[i], splineStarts[i+1], splineStarts[j], splineStarts[j+1], EDGE_DISTANCE_PRECISION);
             distanceMatrix[i][j] = dist;
             distanceMatrix[j][i] = dist;
         }
-    }
+    }, EParallelForFlags::Unbalanced);
 
     std::vector<const double *> graphEdgeDistances;
     graphEdgeDistances.reserve(splineCount*(splineCount-1)/2);
@@ -469,24 +584,18 @@ void edgeColoringByDistance(Shape &shape, double angleThreshold, unsigned long l
     if (!graphEdgeDistances.empty())
         qsort(&graphEdgeDistances[0], graphEdgeDistances.size(), sizeof(const double *), &cmpDoublePtr);
 
-    std::vector<int> edgeMatrixStorage(splineCount*splineCount);
-    std::vector<int *> edgeMatrix(splineCount);
-    for (int i = 0; i < splineCount; ++i)
-        edgeMatrix[i] = &edgeMatrixStorage[i*splineCount];
+    SplineGraph graph(splineCount);
     int nextEdge = 0;
     for (; nextEdge < graphEdgeCount && !*graphEdgeDistances[nextEdge]; ++nextEdge) {
         int elem = (int) (graphEdgeDistances[nextEdge]-distanceMatrixBase);
-        int row = elem/splineCount;
-        int col = elem%splineCount;
-        edgeMatrix[row][col] = 1;
-        edgeMatrix[col][row] = 1;
+        graph.setEdge(elem/splineCount, elem%splineCount, true);
     }
 
-    std::vector<int> coloring(2*splineCount);
-    colorSecondDegreeGraph(&coloring[0], &edgeMatrix[0], splineCount, seed);
+    GraphColoring coloring(splineCount), coloringBuffer(splineCount);
+    colorSecondDegreeGraph(coloring, graph, seed);
     for (; nextEdge < graphEdgeCount; ++nextEdge) {
         int elem = (int) (graphEdgeDistances[nextEdge]-distanceMatrixBase);
-        tryAddEdge(&coloring[0], &edgeMatrix[0], splineCount, elem/splineCount, elem%splineCount, &coloring[splineCount]);
+        tryAddEdge(coloring, graph, elem/splineCount, elem%splineCount, coloringBuffer);
     }
 
     const EdgeColor colors[3] = { YELLOW, CYAN, MAGENTA };
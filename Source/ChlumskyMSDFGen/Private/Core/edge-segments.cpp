@@ -1,5 +1,6 @@
 
 #include "edge-segments.h"
+#include "EdgeHolder.h"
 
 #include "arithmetics.hpp"
 #include "equation-solver.h"
@@ -37,7 +38,7 @@ LinearSegment::LinearSegment(Point2 p0, Point2 p1, EdgeColor edgeColor) : EdgeSe
     p[1] = p1;
 }
 
-QuadraticSegment::QuadraticSegment(Point2 p0, Point2 p1, Point2 p2, EdgeColor edgeColor) : EdgeSegment(SegmentType::Cubic, edgeColor) {
+QuadraticSegment::QuadraticSegment(Point2 p0, Point2 p1, Point2 p2, EdgeColor edgeColor) : EdgeSegment(SegmentType::Quadratic, edgeColor) {
     if (p1 == p0 || p1 == p2)
         p1 = 0.5*(p0+p2);
     p[0] = p0;
@@ -45,7 +46,7 @@ QuadraticSegment::QuadraticSegment(Point2 p0, Point2 p1, Point2 p2, EdgeColor ed
     p[2] = p2;
 }
 
-CubicSegment::CubicSegment(Point2 p0, Point2 p1, Point2 p2, Point2 p3, EdgeColor edgeColor) : EdgeSegment(SegmentType::Quadratic, edgeColor) {
+CubicSegment::CubicSegment(Point2 p0, Point2 p1, Point2 p2, Point2 p3, EdgeColor edgeColor) : EdgeSegment(SegmentType::Cubic, edgeColor) {
     if ((p1 == p0 || p1 == p3) && (p2 == p0 || p2 == p3)) {
         p1 = mix(p0, p3, 1/3.);
         p2 = mix(p0, p3, 2/3.);
@@ -138,13 +139,14 @@ SignedDistance LinearSegment::signedDistance(Point2 origin, double &param) const
     Vector2 ab = p[1]-p[0];
     param = dotProduct(aq, ab)/dotProduct(ab, ab);
     Vector2 eq = p[param > .5]-origin;
-    double endpointDistance = eq.length();
+    // Squared distances are compared so that the square root is only taken if the endpoint wins
+    double endpointSquaredDistance = dotProduct(eq, eq);
     if (param > 0 && param < 1) {
         double orthoDistance = dotProduct(ab.getOrthonormal(false), aq);
-        if (fabs(orthoDistance) < endpointDistance)
+        if (orthoDistance*orthoDistance < endpointSquaredDistance)
             return SignedDistance(orthoDistance, 0);
     }
-    return SignedDistance(nonZeroSign(crossProduct(aq, ab))*endpointDistance, fabs(dotProduct(ab.normalize(), eq.normalize())));
+    return SignedDistance(nonZeroSign(crossProduct(aq, ab))*sqrt(endpointSquaredDistance), fabs(dotProduct(ab.normalize(), eq.normalize())));
 }
 
 SignedDistance QuadraticSegment::signedDistance(Point2 origin, double &param) const {
@@ -158,27 +160,33 @@ SignedDistance QuadraticSegment::signedDistance(Point2 origin, double &param) co
     double t[3];
     int solutions = solveCubic(t, a, b, c, d);
 
+    // Candidates are compared by squared distance, the square root is only taken for the winner
     Vector2 epDir = direction(0);
-    double minDistance = nonZeroSign(crossProduct(epDir, qa))*qa.length(); // distance from A
+    double minSquaredDistance = dotProduct(qa, qa); // distance from A
+    double minDistanceSign = nonZeroSign(crossProduct(epDir, qa));
     param = -dotProduct(qa, epDir)/dotProduct(epDir, epDir);
     {
         epDir = direction(1);
-        double distance = (p[2]-origin).length(); // distance from B
-        if (distance < fabs(minDistance)) {
-            minDistance = nonZeroSign(crossProduct(epDir, p[2]-origin))*distance;
+        Vector2 qb = p[2]-origin;
+        double squaredDistance = dotProduct(qb, qb); // distance from B
+        if (squaredDistance < minSquaredDistance) {
+            minSquaredDistance = squaredDistance;
+            minDistanceSign = nonZeroSign(crossProduct(epDir, qb));
             param = dotProduct(origin-p[1], epDir)/dotProduct(epDir, epDir);
         }
     }
     for (int i = 0; i < solutions; ++i) {
         if (t[i] > 0 && t[i] < 1) {
             Point2 qe = qa+2*t[i]*ab+t[i]*t[i]*br;
-            double distance = qe.length();
-            if (distance <= fabs(minDistance)) {
-                minDistance = nonZeroSign(crossProduct(ab+t[i]*br, qe))*distance;
+            double squaredDistance = dotProduct(qe, qe);
+            if (squaredDistance <= minSquaredDistance) {
+                minSquaredDistance = squaredDistance;
+                minDistanceSign = nonZeroSign(crossProduct(ab+t[i]*br, qe));
                 param = t[i];
             }
         }
     }
+    double minDistance = minDistanceSign*sqrt(minSquaredDistance);
 
     if (param >= 0 && param <= 1)
         return SignedDistance(minDistance, 0);
@@ -194,15 +202,19 @@ SignedDistance CubicSegment::signedDistance(Point2 origin, double &param) const
     Vector2 br = p[2]-p[1]-ab;
     Vector2 as = (p[3]-p[2])-(p[2]-p[1])-br;
 
+    // Candidates are compared by squared distance, the square root is only taken for the winner
     Vector2 epDir = direction(0);
-    double minDistance = nonZeroSign(crossProduct(epDir, qa))*qa.length(); // distance from A
+    double minSquaredDistance = dotProduct(qa, qa); // distance from A
+    double minDistanceSign = nonZeroSign(crossProduct(epDir, qa));
     param = -dotProduct(qa, epDir)/dotProduct(epDir, epDir);
     {
         epDir = direction(1);
-        double distance = (p[3]-origin).length(); // distance from B
-        if (distance < fabs(minDistance)) {
-            minDistance = nonZeroSign(crossProduct(epDir, p[3]-origin))*distance;
-            param = dotProduct(epDir-(p[3]-origin), epDir)/dotProduct(epDir, epDir);
+        Vector2 qb = p[3]-origin;
+        double squaredDistance = dotProduct(qb, qb); // distance from B
+        if (squaredDistance < minSquaredDistance) {
+            minSquaredDistance = squaredDistance;
+            minDistanceSign = nonZeroSign(crossProduct(epDir, qb));
+            param = dotProduct(epDir-qb, epDir)/dotProduct(epDir, epDir);
         }
     }
     // Iterative minimum distance search
@@ -217,13 +229,15 @@ SignedDistance CubicSegment::signedDistance(Point2 origin, double &param) const
             if (t <= 0 || t >= 1)
                 break;
             qe = qa+3*t*ab+3*t*t*br+t*t*t*as;
-            double distance = qe.length();
-            if (distance < fabs(minDistance)) {
-                minDistance = nonZeroSign(crossProduct(d1, qe))*distance;
+            double squaredDistance = dotProduct(qe, qe);
+            if (squaredDistance < minSquaredDistance) {
+                minSquaredDistance = squaredDistance;
+                minDistanceSign = nonZeroSign(crossProduct(d1, qe));
                 param = t;
             }
         }
     }
+    double minDistance = minDistanceSign*sqrt(minSquaredDistance);
 
     if (param >= 0 && param <= 1)
         return SignedDistance(minDistance, 0);
@@ -462,29 +476,29 @@ void CubicSegment::moveEndPoint(Point2 to) {
     p[3] = to;
 }
 
-void LinearSegment::splitInThirds(EdgeSegment *&part1, EdgeSegment *&part2, EdgeSegment *&part3) const {
-    part1 = new LinearSegment(p[0], point(1/3.), color);
-    part2 = new LinearSegment(point(1/3.), point(2/3.), color);
-    part3 = new LinearSegment(point(2/3.), p[1], color);
+void LinearSegment::splitInThirds(EdgeHolder &part1, EdgeHolder &part2, EdgeHolder &part3) const {
+    part1 = EdgeHolder(p[0], point(1/3.), color);
+    part2 = EdgeHolder(point(1/3.), point(2/3.), color);
+    part3 = EdgeHolder(point(2/3.), p[1], color);
 }
 
-void QuadraticSegment::splitInThirds(EdgeSegment *&part1, EdgeSegment *&part2, EdgeSegment *&part3) const {
-    part1 = new QuadraticSegment(p[0], mix(p[0], p[1], 1/3.), point(1/3.), color);
-    part2 = new QuadraticSegment(point(1/3.), mix(mix(p[0], p[1], 5/9.), mix(p[1], p[2], 4/9.), .5), point(2/3.), color);
-    part3 = new QuadraticSegment(point(2/3.), mix(p[1], p[2], 2/3.), p[2], color);
+void QuadraticSegment::splitInThirds(EdgeHolder &part1, EdgeHolder &part2, EdgeHolder &part3) const {
+    part1 = EdgeHolder(p[0], mix(p[0], p[1], 1/3.), point(1/3.), color);
+    part2 = EdgeHolder(point(1/3.), mix(mix(p[0], p[1], 5/9.), mix(p[1], p[2], 4/9.), .5), point(2/3.), color);
+    part3 = EdgeHolder(point(2/3.), mix(p[1], p[2], 2/3.), p[2], color);
 }
 
-void CubicSegment::splitInThirds(EdgeSegment *&part1, EdgeSegment *&part2, EdgeSegment *&part3) const {
-    part1 = new CubicSegment(p[0], p[0] == p[1] ? p[0] : mix(p[0], p[1], 1/3.), mix(mix(p[0], p[1], 1/3.), mix(p[1], p[2], 1/3.), 1/3.), point(1/3.), color);
-    part2 = new CubicSegment(point(1/3.),
+void CubicSegment::splitInThirds(EdgeHolder &part1, EdgeHolder &part2, EdgeHolder &part3) const {
+    part1 = EdgeHolder(p[0], p[0] == p[1] ? p[0] : mix(p[0], p[1], 1/3.), mix(mix(p[0], p[1], 1/3.), mix(p[1], p[2], 1/3.), 1/3.), point(1/3.), color);
+    part2 = EdgeHolder(point(1/3.),
         mix(mix(mix(p[0], p[1], 1/3.), mix(p[1], p[2], 1/3.), 1/3.), mix(mix(p[1], p[2], 1/3.), mix(p[2], p[3], 1/3.), 1/3.), 2/3.),
         mix(mix(mix(p[0], p[1], 2/3.), mix(p[1], p[2], 2/3.), 2/3.), mix(mix(p[1], p[2], 2/3.), mix(p[2], p[3], 2/3.), 2/3.), 1/3.),
         point(2/3.), color);
-    part3 = new CubicSegment(point(2/3.), mix(mix(p[1], p[2], 2/3.), mix(p[2], p[3], 2/3.), 2/3.), p[2] == p[3] ? p[3] : mix(p[2], p[3], 2/3.), p[3], color);
+    part3 = EdgeHolder(point(2/3.), mix(mix(p[1], p[2], 2/3.), mix(p[2], p[3], 2/3.), 2/3.), p[2] == p[3] ? p[3] : mix(p[2], p[3], 2/3.), p[3], color);
 }
 
-EdgeSegment * QuadraticSegment::convertToCubic() const {
-    return new CubicSegment(p[0], mix(p[0], p[1], 2/3.), mix(p[1], p[2], 1/3.), p[2], color);
+EdgeHolder QuadraticSegment::convertToCubic() const {
+    return EdgeHolder(p[0], mix(p[0], p[1], 2/3.), mix(p[1], p[2], 1/3.), p[2], color);
 }
 
 void CubicSegment::deconverge(int param, double amount) {
@@ -7,35 +7,59 @@ namespace msdfgen {
 
 #define DISTANCE_DELTA_FACTOR 1.001
 
+/// Equivalent to value <= DISTANCE_DELTA_FACTOR*sqrt(squaredOffset), evaluated without the square root.
+static inline bool withinDelta(double value, double squaredOffset) {
+    return value <= 0 || value*value <= DISTANCE_DELTA_FACTOR*DISTANCE_DELTA_FACTOR*squaredOffset;
+}
+
+/// Equivalent to value < DISTANCE_DELTA_FACTOR*sqrt(squaredOffset), evaluated without the square root.
+static inline bool strictlyWithinDelta(double value, double squaredOffset) {
+    return value < 0 || value*value < DISTANCE_DELTA_FACTOR*DISTANCE_DELTA_FACTOR*squaredOffset;
+}
+
 TrueDistanceSelector::EdgeCache::EdgeCache() : absDistance(0) { }
 
+TrueDistanceSelector::TrueDistanceSelector() : nearEdge(NULL) { }
+
 void TrueDistanceSelector::reset(const Point2 &p) {
     double delta = DISTANCE_DELTA_FACTOR*(p-this->p).length();
     minDistance.distance += nonZeroSign(minDistance.distance)*delta;
+    nearEdge = NULL;
     this->p = p;
 }
 
 void TrueDistanceSelector::addEdge(EdgeCache &cache, const EdgeSegment *prevEdge, const EdgeSegment *edge, const EdgeSegment *nextEdge) {
-    double delta = DISTANCE_DELTA_FACTOR*(p-cache.point).length();
-    if (cache.absDistance-delta <= fabs(minDistance.distance)) {
+    if (withinDelta(cache.absDistance-fabs(minDistance.distance), (p-cache.point).squaredLength())) {
         double dummy;
         SignedDistance distance = edge->signedDistance(p, dummy);
-        if (distance < minDistance)
+        if (distance < minDistance) {
             minDistance = distance;
+            nearEdge = edge;
+        }
         cache.point = p;
         cache.absDistance = fabs(distance.distance);
     }
 }
 
 void TrueDistanceSelector::merge(const TrueDistanceSelector &other) {
-    if (other.minDistance < minDistance)
+    if (other.minDistance < minDistance) {
         minDistance = other.minDistance;
+        nearEdge = other.nearEdge;
+    }
 }
 
 TrueDistanceSelector::DistanceType TrueDistanceSelector::distance() const {
     return minDistance.distance;
 }
 
+SignedDistance TrueDistanceSelector::trueDistance() const {
+    return minDistance;
+}
+
+const EdgeSegment * TrueDistanceSelector::nearestEdge() const {
+    return nearEdge;
+}
+
 PseudoDistanceSelectorBase::EdgeCache::EdgeCache() : absDistance(0), aDomainDistance(0), bDomainDistance(0), aPseudoDistance(0), bPseudoDistance(0) { }
 
 bool PseudoDistanceSelectorBase::getPseudoDistance(double &distance, const Vector2 &ep, const Vector2 &edgeDir) {
@@ -61,18 +85,19 @@ void PseudoDistanceSelectorBase::reset(double delta) {
 }
 
 bool PseudoDistanceSelectorBase::isEdgeRelevant(const EdgeCache &cache, const EdgeSegment *edge, const Point2 &p) const {
-    double delta = DISTANCE_DELTA_FACTOR*(p-cache.point).length();
+    // Each condition has the form value <= delta, where delta = DISTANCE_DELTA_FACTOR*|p-cache.point|, and is tested on squares
+    double squaredOffset = (p-cache.point).squaredLength();
     return (
-        cache.absDistance-delta <= fabs(minTrueDistance.distance) ||
-        fabs(cache.aDomainDistance) < delta ||
-        fabs(cache.bDomainDistance) < delta ||
+        withinDelta(cache.absDistance-fabs(minTrueDistance.distance), squaredOffset) ||
+        strictlyWithinDelta(fabs(cache.aDomainDistance), squaredOffset) ||
+        strictlyWithinDelta(fabs(cache.bDomainDistance), squaredOffset) ||
         (cache.aDomainDistance > 0 && (cache.aPseudoDistance < 0 ?
-            cache.aPseudoDistance+delta >= minNegativePseudoDistance :
-            cache.aPseudoDistance-delta <= minPositivePseudoDistance
+            withinDelta(minNegativePseudoDistance-cache.aPseudoDistance, squaredOffset) :
+            withinDelta(cache.aPseudoDistance-minPositivePseudoDistance, squaredOffset)
         )) ||
         (cache.bDomainDistance > 0 && (cache.bPseudoDistance < 0 ?
-            cache.bPseudoDistance+delta >= minNegativePseudoDistance :
-            cache.bPseudoDistance-delta <= minPositivePseudoDistance
+            withinDelta(minNegativePseudoDistance-cache.bPseudoDistance, squaredOffset) :
+            withinDelta(cache.bPseudoDistance-minPositivePseudoDistance, squaredOffset)
         ))
     );
 }
@@ -119,6 +144,10 @@ SignedDistance PseudoDistanceSelectorBase::trueDistance() const {
     return minTrueDistance;
 }
 
+const EdgeSegment * PseudoDistanceSelectorBase::nearestEdge() const {
+    return nearEdge;
+}
+
 void PseudoDistanceSelector::reset(const Point2 &p) {
     double delta = DISTANCE_DELTA_FACTOR*(p-this->p).length();
     PseudoDistanceSelectorBase::reset(delta);
@@ -248,6 +277,15 @@ SignedDistance MultiDistanceSelector::trueDistance() const {
     return distance;
 }
 
+const EdgeSegment * MultiDistanceSelector::nearestEdge() const {
+    const PseudoDistanceSelectorBase *nearest = &r;
+    if (g.trueDistance() < nearest->trueDistance())
+        nearest = &g;
+    if (b.trueDistance() < nearest->trueDistance())
+        nearest = &b;
+    return nearest->nearestEdge();
+}
+
 MultiAndTrueDistanceSelector::DistanceType MultiAndTrueDistanceSelector::distance() const {
     MultiDistance multiDistance = MultiDistanceSelector::distance();
     MultiAndTrueDistance mtd;
@@ -3,7 +3,6 @@
 
 #include <vector>
 #include "arithmetics.hpp"
-#include "Bitmap.h"
 #include "contour-combiners.h"
 #include "MSDFErrorCorrection.h"
 
@@ -11,17 +10,19 @@ namespace msdfgen {
 
 template <int N>
 static void msdfErrorCorrectionInner(const BitmapRef<float, N> &sdf, const Shape &shape, const Projection &projection, double range, const MSDFGeneratorConfig &config) {
-    if (config.errorCorrection.mode == ErrorCorrectionConfig::DISABLED)
+    if (config.errorCorrection.mode == ErrorCorrectionConfig::DISABLED || sdf.width <= 0 || sdf.height <= 0)
         return;
-    Bitmap<byte, 1> stencilBuffer;
+    std::vector<MSDFErrorCorrection::StencilWord> stencilBuffer;
     if (!config.errorCorrection.buffer)
-        stencilBuffer = Bitmap<byte, 1>(sdf.width, sdf.height);
-    BitmapRef<byte, 1> stencil;
-    stencil.pixels = config.errorCorrection.buffer ? config.errorCorrection.buffer : (byte *) stencilBuffer;
-    stencil.width = sdf.width, stencil.height = sdf.height;
-    MSDFErrorCorrection ec(stencil, projection, range);
+        stencilBuffer.resize(MSDFErrorCorrection::stencilBufferSize(sdf.width, sdf.height)/sizeof(MSDFErrorCorrection::StencilWord));
+    byte *stencil = config.errorCorrection.buffer ? config.errorCorrection.buffer : reinterpret_cast<byte *>(&stencilBuffer[0]);
+    MSDFErrorCorrection ec(stencil, sdf.width, sdf.height, projection, range);
     ec.setMinDeviationRatio(config.errorCorrection.minDeviationRatio);
     ec.setMinImproveRatio(config.errorCorrection.minImproveRatio);
+    // The local edges only stand in for the shape distance without overlap support, as the generator doesn't record them otherwise
+    if (config.errorCorrection.nearestEdgeBuffer && !config.overlapSupport)
+        ec.setNearestEdges(BitmapConstRef<int, 1>(config.errorCorrection.nearestEdgeBuffer, sdf.width, sdf.height));
+    ec.classifyTiles<N>(sdf);
     switch (config.errorCorrection.mode) {
         case ErrorCorrectionConfig::DISABLED:
         case ErrorCorrectionConfig::INDISCRIMINATE:
@@ -50,9 +51,12 @@ static void msdfErrorCorrectionInner(const BitmapRef<float, N> &sdf, const Shape
 
 template <int N>
 static void msdfErrorCorrectionShapeless(const BitmapRef<float, N> &sdf, const Projection &projection, double range, double minDeviationRatio, bool protectAll) {
-    Bitmap<byte, 1> stencilBuffer(sdf.width, sdf.height);
-    MSDFErrorCorrection ec(stencilBuffer, projection, range);
+    if (sdf.width <= 0 || sdf.height <= 0)
+        return;
+    std::vector<MSDFErrorCorrection::StencilWord> stencilBuffer(MSDFErrorCorrection::stencilBufferSize(sdf.width, sdf.height)/sizeof(MSDFErrorCorrection::StencilWord));
+    MSDFErrorCorrection ec(reinterpret_cast<byte *>(&stencilBuffer[0]), sdf.width, sdf.height, projection, range);
     ec.setMinDeviationRatio(minDeviationRatio);
+    ec.classifyTiles<N>(sdf);
     if (protectAll)
         ec.protectAll();
     ec.findErrors<N>(sdf);
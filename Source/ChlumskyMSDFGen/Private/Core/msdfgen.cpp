@@ -2,9 +2,15 @@
 #include "msdfgen.h"
 
 #include <vector>
+#include <algorithm>
 #include "edge-selectors.h"
 #include "contour-combiners.h"
 #include "ShapeDistanceFinder.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+
+/// Approximate number of pixels processed by a single work item of generateBatch. Jobs up to twice this size are not split.
+#define MSDFGEN_BATCH_TILE_PIXELS 16384
 
 namespace msdfgen {
 
@@ -49,8 +55,38 @@ public:
     }
 };
 
+/// Maps edge segments to their index in the sequence of all edges of a shape, as expected by ErrorCorrectionConfig::nearestEdgeBuffer.
+class EdgeIndexLookup {
+public:
+    /// Builds the lookup for the given shape, or an empty lookup if shape is NULL.
+    explicit EdgeIndexLookup(const Shape *shape) {
+        if (!shape)
+            return;
+        edges.reserve(shape->edgeCount());
+        for (std::vector<Contour>::const_iterator contour = shape->contours.begin(); contour != shape->contours.end(); ++contour)
+            for (std::vector<EdgeHolder>::const_iterator edge = contour->edges.begin(); edge != contour->edges.end(); ++edge)
+                edges.push_back(std::make_pair((const EdgeSegment *) *edge, (int) edges.size()));
+        std::sort(edges.begin(), edges.end());
+    }
+    int operator()(const EdgeSegment *edge) const {
+        std::vector<std::pair<const EdgeSegment *, int> >::const_iterator it = std::lower_bound(edges.begin(), edges.end(), std::make_pair(edge, -1));
+        return it != edges.end() && it->first == edge ? it->second : -1;
+    }
+private:
+    std::vector<std::pair<const EdgeSegment *, int> > edges;
+};
+
+/// Returns the buffer for the nearest edges of the MSDF pixels if the error correction is going to use them.
+/// With overlap support, the distance to the shape depends on whole contours, so the error correction evaluates the full shape instead.
+static int * nearestEdgeBuffer(const MSDFGeneratorConfig &config) {
+    const ErrorCorrectionConfig &ec = config.errorCorrection;
+    if (config.overlapSupport || ec.mode == ErrorCorrectionConfig::DISABLED || ec.distanceCheckMode == ErrorCorrectionConfig::DO_NOT_CHECK_DISTANCE)
+        return NULL;
+    return ec.nearestEdgeBuffer;
+}
+
 template <class ContourCombiner>
-void generateDistanceField(const typename DistancePixelConversion<typename ContourCombiner::DistanceType>::BitmapRefType &output, const Shape &shape, const Projection &projection, double range) {
+void generateDistanceField(const typename DistancePixelConversion<typename ContourCombiner::DistanceType>::BitmapRefType &output, const Shape &shape, const Projection &projection, double range, int rowStart, int rowEnd, int *nearestEdges = NULL, const EdgeIndexLookup *edgeIndex = NULL) {
     DistancePixelConversion<typename ContourCombiner::DistanceType> distancePixelConversion(range);
 #ifdef MSDFGEN_USE_OPENMP
     #pragma omp parallel
@@ -61,13 +97,15 @@ void generateDistanceField(const typename DistancePixelConversion<typename Conto
 #ifdef MSDFGEN_USE_OPENMP
         #pragma omp for
 #endif
-        for (int y = 0; y < output.height; ++y) {
+        for (int y = rowStart; y < rowEnd; ++y) {
             int row = shape.inverseYAxis ? output.height-y-1 : y;
             for (int col = 0; col < output.width; ++col) {
                 int x = rightToLeft ? output.width-col-1 : col;
                 Point2 p = projection.unproject(Point2(x+.5, y+.5));
                 typename ContourCombiner::DistanceType distance = distanceFinder.distance(p);
                 distancePixelConversion(output(x, row), distance);
+                if (nearestEdges)
+                    nearestEdges[output.width*row+x] = (*edgeIndex)(distanceFinder.nearestEdge());
             }
             rightToLeft = !rightToLeft;
         }
@@ -76,34 +114,145 @@ void generateDistanceField(const typename DistancePixelConversion<typename Conto
 
 void generateSDF(const BitmapRef<float, 1> &output, const Shape &shape, const Projection &projection, double range, const GeneratorConfig &config) {
     if (config.overlapSupport)
-        generateDistanceField<OverlappingContourCombiner<TrueDistanceSelector> >(output, shape, projection, range);
+        generateDistanceField<OverlappingContourCombiner<TrueDistanceSelector> >(output, shape, projection, range, 0, output.height);
     else
-        generateDistanceField<SimpleContourCombiner<TrueDistanceSelector> >(output, shape, projection, range);
+        generateDistanceField<SimpleContourCombiner<TrueDistanceSelector> >(output, shape, projection, range, 0, output.height);
 }
 
 void generatePseudoSDF(const BitmapRef<float, 1> &output, const Shape &shape, const Projection &projection, double range, const GeneratorConfig &config) {
     if (config.overlapSupport)
-        generateDistanceField<OverlappingContourCombiner<PseudoDistanceSelector> >(output, shape, projection, range);
+        generateDistanceField<OverlappingContourCombiner<PseudoDistanceSelector> >(output, shape, projection, range, 0, output.height);
     else
-        generateDistanceField<SimpleContourCombiner<PseudoDistanceSelector> >(output, shape, projection, range);
+        generateDistanceField<SimpleContourCombiner<PseudoDistanceSelector> >(output, shape, projection, range, 0, output.height);
 }
 
 void generateMSDF(const BitmapRef<float, 3> &output, const Shape &shape, const Projection &projection, double range, const MSDFGeneratorConfig &config) {
+    int *nearestEdges = nearestEdgeBuffer(config);
+    EdgeIndexLookup edgeIndex(nearestEdges ? &shape : NULL);
     if (config.overlapSupport)
-        generateDistanceField<OverlappingContourCombiner<MultiDistanceSelector> >(output, shape, projection, range);
+        generateDistanceField<OverlappingContourCombiner<MultiDistanceSelector> >(output, shape, projection, range, 0, output.height, nearestEdges, &edgeIndex);
     else
-        generateDistanceField<SimpleContourCombiner<MultiDistanceSelector> >(output, shape, projection, range);
+        generateDistanceField<SimpleContourCombiner<MultiDistanceSelector> >(output, shape, projection, range, 0, output.height, nearestEdges, &edgeIndex);
     msdfErrorCorrection(output, shape, projection, range, config);
 }
 
 void generateMTSDF(const BitmapRef<float, 4> &output, const Shape &shape, const Projection &projection, double range, const MSDFGeneratorConfig &config) {
+    int *nearestEdges = nearestEdgeBuffer(config);
+    EdgeIndexLookup edgeIndex(nearestEdges ? &shape : NULL);
     if (config.overlapSupport)
-        generateDistanceField<OverlappingContourCombiner<MultiAndTrueDistanceSelector> >(output, shape, projection, range);
+        generateDistanceField<OverlappingContourCombiner<MultiAndTrueDistanceSelector> >(output, shape, projection, range, 0, output.height, nearestEdges, &edgeIndex);
     else
-        generateDistanceField<SimpleContourCombiner<MultiAndTrueDistanceSelector> >(output, shape, projection, range);
+        generateDistanceField<SimpleContourCombiner<MultiAndTrueDistanceSelector> >(output, shape, projection, range, 0, output.height, nearestEdges, &edgeIndex);
     msdfErrorCorrection(output, shape, projection, range, config);
 }
 
+// Batch API
+
+template <template <typename> class ContourCombiner>
+static void generateJobRows(const GeneratorJob &job, int rowStart, int rowEnd, const EdgeIndexLookup *edgeIndex) {
+    switch (job.type) {
+        case GENERATE_SDF:
+            generateDistanceField<ContourCombiner<TrueDistanceSelector> >(BitmapRef<float, 1>(job.pixels, job.width, job.height), *job.shape, job.projection, job.range, rowStart, rowEnd);
+            break;
+        case GENERATE_PSEUDO_SDF:
+            generateDistanceField<ContourCombiner<PseudoDistanceSelector> >(BitmapRef<float, 1>(job.pixels, job.width, job.height), *job.shape, job.projection, job.range, rowStart, rowEnd);
+            break;
+        case GENERATE_MSDF:
+            generateDistanceField<ContourCombiner<MultiDistanceSelector> >(BitmapRef<float, 3>(job.pixels, job.width, job.height), *job.shape, job.projection, job.range, rowStart, rowEnd, nearestEdgeBuffer(job.config), edgeIndex);
+            break;
+        case GENERATE_MTSDF:
+            generateDistanceField<ContourCombiner<MultiAndTrueDistanceSelector> >(BitmapRef<float, 4>(job.pixels, job.width, job.height), *job.shape, job.projection, job.range, rowStart, rowEnd, nearestEdgeBuffer(job.config), edgeIndex);
+            break;
+    }
+}
+
+static void generateJobRows(const GeneratorJob &job, int rowStart, int rowEnd, const EdgeIndexLookup *edgeIndex) {
+    if (job.config.overlapSupport)
+        generateJobRows<OverlappingContourCombiner>(job, rowStart, rowEnd, edgeIndex);
+    else
+        generateJobRows<SimpleContourCombiner>(job, rowStart, rowEnd, edgeIndex);
+}
+
+static void correctJobErrors(const GeneratorJob &job) {
+    switch (job.type) {
+        case GENERATE_MSDF:
+            msdfErrorCorrection(BitmapRef<float, 3>(job.pixels, job.width, job.height), *job.shape, job.projection, job.range, job.config);
+            break;
+        case GENERATE_MTSDF:
+            msdfErrorCorrection(BitmapRef<float, 4>(job.pixels, job.width, job.height), *job.shape, job.projection, job.range, job.config);
+            break;
+        default:;
+    }
+}
+
+struct BatchWorkItem {
+    int job;
+    int rowStart, rowEnd;
+    long long pixels;
+};
+
+static bool cmpBatchWorkItems(const BatchWorkItem &a, const BatchWorkItem &b) {
+    return a.pixels > b.pixels;
+}
+
+void generateBatch(const GeneratorJob *jobs, int jobCount, BatchGeneratorStats *stats) {
+    double startTime = FPlatformTime::Seconds();
+    std::vector<BatchWorkItem> tiles, wholeJobs;
+    std::vector<int> tiledJobs;
+    // Edge indices are looked up once per job and shared by all of its tiles
+    std::vector<EdgeIndexLookup> edgeIndices;
+    edgeIndices.reserve(jobCount);
+    long long pixelCount = 0;
+    for (int i = 0; i < jobCount; ++i) {
+        const GeneratorJob &job = jobs[i];
+        bool recordsNearestEdges = (job.type == GENERATE_MSDF || job.type == GENERATE_MTSDF) && nearestEdgeBuffer(job.config);
+        edgeIndices.push_back(EdgeIndexLookup(recordsNearestEdges ? (const Shape *) job.shape : NULL));
+        if (!job.shape || !job.pixels || job.width <= 0 || job.height <= 0)
+            continue;
+        long long pixels = (long long) job.width*job.height;
+        pixelCount += pixels;
+        if (pixels <= 2*MSDFGEN_BATCH_TILE_PIXELS) {
+            BatchWorkItem item = { i, 0, job.height, pixels };
+            wholeJobs.push_back(item);
+        } else {
+            int tileRows = std::max(1, MSDFGEN_BATCH_TILE_PIXELS/job.width);
+            for (int rowStart = 0; rowStart < job.height; rowStart += tileRows) {
+                BatchWorkItem item = { i, rowStart, std::min(rowStart+tileRows, job.height), 0 };
+                item.pixels = (long long) job.width*(item.rowEnd-item.rowStart);
+                tiles.push_back(item);
+            }
+            tiledJobs.push_back(i);
+        }
+    }
+
+    // Tiles go first so that the error correction of large jobs can start as early as possible,
+    // the remaining whole jobs are handed out largest first to balance the tail of the batch.
+    std::stable_sort(wholeJobs.begin(), wholeJobs.end(), cmpBatchWorkItems);
+    std::vector<BatchWorkItem> items(tiles);
+    items.insert(items.end(), wholeJobs.begin(), wholeJobs.end());
+    int tileCount = (int) tiles.size();
+
+    ParallelFor((int32) items.size(), [&](int32 i) {
+        const BatchWorkItem &item = items[i];
+        generateJobRows(jobs[item.job], item.rowStart, item.rowEnd, &edgeIndices[item.job]);
+        if (i >= tileCount)
+            correctJobErrors(jobs[item.job]);
+    }, EParallelForFlags::Unbalanced);
+
+    // Error correction operates on the whole image and can only run after all tiles of a job are complete
+    ParallelFor((int32) tiledJobs.size(), [&](int32 i) {
+        correctJobErrors(jobs[tiledJobs[i]]);
+    }, EParallelForFlags::Unbalanced);
+
+    if (stats) {
+        stats->jobCount = jobCount;
+        stats->tiledJobCount = (int) tiledJobs.size();
+        stats->taskCount = (int) (items.size()+tiledJobs.size());
+        stats->pixelCount = pixelCount;
+        stats->seconds = FPlatformTime::Seconds()-startTime;
+    }
+}
+
 // Legacy API
 
 void generateSDF(const BitmapRef<float, 1> &output, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate, bool overlapSupport) {
@@ -0,0 +1,198 @@
+
+#include "shape-binary.h"
+
+#include <cstring>
+
+namespace msdfgen {
+
+static const char SHAPE_BINARY_MAGIC[4] = { 'M', 'S', 'D', 'S' };
+
+static int segmentPointCount(EdgeSegment::SegmentType type) {
+    switch (type) {
+        case EdgeSegment::SegmentType::Linear:
+            return 2;
+        case EdgeSegment::SegmentType::Quadratic:
+            return 3;
+        case EdgeSegment::SegmentType::Cubic:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static const Point2 * segmentPoints(const EdgeSegment *edge) {
+    switch (edge->type) {
+        case EdgeSegment::SegmentType::Linear:
+            return static_cast<const LinearSegment *>(edge)->p;
+        case EdgeSegment::SegmentType::Quadratic:
+            return static_cast<const QuadraticSegment *>(edge)->p;
+        case EdgeSegment::SegmentType::Cubic:
+            return static_cast<const CubicSegment *>(edge)->p;
+        default:
+            return NULL;
+    }
+}
+
+/// Offsets of the arrays following the header.
+struct ShapeBinaryLayout {
+    size_t contourEnds, types, colors, points, end;
+
+    ShapeBinaryLayout(size_t contourCount, size_t edgeCount, size_t pointCount) {
+        contourEnds = sizeof(ShapeBinaryHeader);
+        types = contourEnds+sizeof(uint32_t)*contourCount;
+        colors = types+edgeCount;
+        points = (colors+edgeCount+7)&~(size_t) 7;
+        end = points+2*sizeof(double)*pointCount;
+    }
+};
+
+ShapeBinaryView::ShapeBinaryView(const void *data, size_t size) : header(NULL), contourEnds(NULL), types(NULL), colors(NULL), points(NULL) {
+    if (!data || size < sizeof(ShapeBinaryHeader))
+        return;
+    const ShapeBinaryHeader *candidate = reinterpret_cast<const ShapeBinaryHeader *>(data);
+    if (memcmp(candidate->magic, SHAPE_BINARY_MAGIC, sizeof(SHAPE_BINARY_MAGIC)) || candidate->version != MSDFGEN_SHAPE_BINARY_VERSION)
+        return;
+    // Each edge has at most 4 points, which also bounds the layout arithmetic below
+    if ((uint64_t) candidate->pointCount > 4*(uint64_t) candidate->edgeCount)
+        return;
+    ShapeBinaryLayout layout(candidate->contourCount, candidate->edgeCount, candidate->pointCount);
+    if (layout.end > size)
+        return;
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    header = candidate;
+    contourEnds = bytes+layout.contourEnds;
+    types = bytes+layout.types;
+    colors = bytes+layout.colors;
+    points = bytes+layout.points;
+}
+
+bool ShapeBinaryView::valid() const {
+    return header != NULL;
+}
+
+int ShapeBinaryView::contourCount() const {
+    return header ? (int) header->contourCount : 0;
+}
+
+int ShapeBinaryView::edgeCount() const {
+    return header ? (int) header->edgeCount : 0;
+}
+
+bool ShapeBinaryView::inverseYAxis() const {
+    return header && (header->flags&MSDFGEN_SHAPE_BINARY_INVERSE_Y_AXIS);
+}
+
+int ShapeBinaryView::contourEnd(int contour) const {
+    uint32_t end;
+    memcpy(&end, contourEnds+sizeof(uint32_t)*contour, sizeof(uint32_t));
+    return (int) end;
+}
+
+EdgeSegment::SegmentType ShapeBinaryView::segmentType(int edge) const {
+    return (EdgeSegment::SegmentType) types[edge];
+}
+
+EdgeColor ShapeBinaryView::edgeColor(int edge) const {
+    return (EdgeColor) colors[edge];
+}
+
+Point2 ShapeBinaryView::point(int index) const {
+    double coords[2];
+    memcpy(coords, points+2*sizeof(double)*index, sizeof(coords));
+    return Point2(coords[0], coords[1]);
+}
+
+bool ShapeBinaryView::read(Shape &output) const {
+    if (!header)
+        return false;
+    std::vector<Contour> contours(header->contourCount);
+    int edge = 0, pointIndex = 0;
+    for (int i = 0; i < (int) contours.size(); ++i) {
+        int end = contourEnd(i);
+        if (end < edge || end > (int) header->edgeCount)
+            return false;
+        contours[i].edges.reserve(end-edge);
+        for (; edge < end; ++edge) {
+            int pointCount = segmentPointCount(segmentType(edge));
+            if (!pointCount || pointIndex+pointCount > (int) header->pointCount)
+                return false;
+            EdgeColor color = (EdgeColor) (colors[edge]&WHITE);
+            Point2 p[4];
+            for (int j = 0; j < pointCount; ++j)
+                p[j] = point(pointIndex++);
+            switch (pointCount) {
+                case 2:
+                    contours[i].edges.push_back(EdgeHolder(p[0], p[1], color));
+                    break;
+                case 3:
+                    contours[i].edges.push_back(EdgeHolder(p[0], p[1], p[2], color));
+                    break;
+                default:
+                    contours[i].edges.push_back(EdgeHolder(p[0], p[1], p[2], p[3], color));
+            }
+        }
+    }
+    if (edge != (int) header->edgeCount || pointIndex != (int) header->pointCount)
+        return false;
+    output.contours.swap(contours);
+    output.inverseYAxis = inverseYAxis();
+    return true;
+}
+
+static void countShape(const Shape &shape, size_t &edgeCount, size_t &pointCount) {
+    edgeCount = 0, pointCount = 0;
+    for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour) {
+        edgeCount += contour->edges.size();
+        for (std::vector<EdgeHolder>::const_iterator edge = contour->edges.begin(); edge != contour->edges.end(); ++edge)
+            pointCount += segmentPointCount((*edge)->type);
+    }
+}
+
+size_t shapeBinarySize(const Shape &shape) {
+    size_t edgeCount, pointCount;
+    countShape(shape, edgeCount, pointCount);
+    return ShapeBinaryLayout(shape.contours.size(), edgeCount, pointCount).end;
+}
+
+size_t writeShapeBinary(void *output, size_t outputSize, const Shape &shape) {
+    size_t edgeCount, pointCount;
+    countShape(shape, edgeCount, pointCount);
+    ShapeBinaryLayout layout(shape.contours.size(), edgeCount, pointCount);
+    if (!output || outputSize < layout.end)
+        return 0;
+    unsigned char *bytes = reinterpret_cast<unsigned char *>(output);
+    memset(bytes, 0, layout.end);
+
+    ShapeBinaryHeader header;
+    memcpy(header.magic, SHAPE_BINARY_MAGIC, sizeof(SHAPE_BINARY_MAGIC));
+    header.version = MSDFGEN_SHAPE_BINARY_VERSION;
+    header.flags = shape.inverseYAxis ? MSDFGEN_SHAPE_BINARY_INVERSE_Y_AXIS : 0;
+    header.contourCount = (uint32_t) shape.contours.size();
+    header.edgeCount = (uint32_t) edgeCount;
+    header.pointCount = (uint32_t) pointCount;
+    memcpy(bytes, &header, sizeof(header));
+
+    uint32_t edge = 0;
+    unsigned char *contourEnd = bytes+layout.contourEnds, *type = bytes+layout.types, *color = bytes+layout.colors, *point = bytes+layout.points;
+    for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour) {
+        for (std::vector<EdgeHolder>::const_iterator e = contour->edges.begin(); e != contour->edges.end(); ++e, ++edge) {
+            *type++ = (unsigned char) (*e)->type;
+            *color++ = (unsigned char) (*e)->color;
+            const Point2 *p = segmentPoints(*e);
+            for (int j = 0, n = segmentPointCount((*e)->type); j < n; ++j) {
+                double coords[2] = { p[j].x, p[j].y };
+                memcpy(point, coords, sizeof(coords));
+                point += sizeof(coords);
+            }
+        }
+        memcpy(contourEnd, &edge, sizeof(edge));
+        contourEnd += sizeof(edge);
+    }
+    return layout.end;
+}
+
+bool readShapeBinary(const void *data, size_t size, Shape &output) {
+    return ShapeBinaryView(data, size).read(output);
+}
+
+}
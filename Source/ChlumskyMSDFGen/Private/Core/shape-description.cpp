@@ -264,7 +264,7 @@ bool writeShapeDescription(FILE *output, const Shape &shape) {
                     writeCoord(output, e->p[1]);
                     fprintf(output, ");\n");
                 }
-                if((*edge)->type == EdgeSegment::SegmentType::Quadratic){
+                if((*edge)->type == EdgeSegment::SegmentType::Cubic){
                     const CubicSegment *e = static_cast<const CubicSegment *>(&**edge);
                     fprintf(output, "\t");
                     writeCoord(output, e->p[0]);
@@ -1,11 +1,19 @@
 
 #include "Ext/import-font.h"
+#include "Core/SharedShape.h"
+#include "Core/arithmetics.hpp"
 
 #include <cstdlib>
+#include <mutex>
 #include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_OUTLINE_H
+#include FT_TRUETYPE_TABLES_H
+#include FT_TRUETYPE_TAGS_H
 
 namespace msdfgen {
 
@@ -22,6 +30,17 @@ class FreetypeHandle {
 
 };
 
+/// A decoded glyph outline kept by its font.
+struct CachedGlyph {
+    SharedShape shape;
+    double advance;
+};
+
+static FT_Face acquireGlyphFace(FontHandle *font);
+static void releaseGlyphFace(FontHandle *font, FT_Face face);
+static void cacheGlyph(FontHandle *font, GlyphIndex glyphIndex, const Shape &shape, double advance);
+static bool findCachedGlyph(Shape &output, double *advance, FontHandle *font, GlyphIndex glyphIndex);
+
 class FontHandle {
     friend FontHandle * adoptFreetypeFont(FT_Face ftFace);
     friend FontHandle * loadFont(FreetypeHandle *library, const char *filename);
@@ -34,10 +53,32 @@ class FontHandle {
     friend bool loadGlyph(Shape &output, FontHandle *font, unicode_t unicode, double *advance);
     friend bool getKerning(double &output, FontHandle *font, GlyphIndex glyphIndex1, GlyphIndex glyphIndex2);
     friend bool getKerning(double &output, FontHandle *font, unicode_t unicode1, unicode_t unicode2);
+    friend bool getKerningPairs(std::vector<std::pair<GlyphIndex, GlyphIndex> > &output, FontHandle *font);
+    friend FT_Face acquireGlyphFace(FontHandle *font);
+    friend void releaseGlyphFace(FontHandle *font, FT_Face face);
+    friend void cacheGlyph(FontHandle *font, GlyphIndex glyphIndex, const Shape &shape, double advance);
+    friend bool findCachedGlyph(Shape &output, double *advance, FontHandle *font, GlyphIndex glyphIndex);
 
     FT_Face face;
     bool ownership;
 
+    /// Source of the font's additional faces. Adopted fonts have no library and load glyphs one at a time with their own face instead.
+    FT_Library library;
+    std::string filename;
+    const byte *data;
+    int length;
+    /// Faces for loading glyphs, one for each thread that has been loading at the same time. Faces not in use wait in idleFaces.
+    std::vector<FT_Face> glyphFaces, idleFaces;
+    /// Guards the face lists, and the library while faces are created. Held for the whole load by glyphs of adopted fonts.
+    std::mutex faceMutex;
+    std::unordered_map<unsigned, CachedGlyph> glyphCache;
+    /// Glyph indices of the characters loaded so far, so loading one again doesn't need a face to look it up
+    std::unordered_map<unicode_t, unsigned> charIndices;
+    /// Guards glyphCache and charIndices
+    std::mutex glyphCacheMutex;
+
+    FontHandle() : face(NULL), ownership(false), library(NULL), data(NULL), length(0) { }
+
 };
 
 struct FtContext {
@@ -124,6 +165,8 @@ FontHandle * loadFont(FreetypeHandle *library, const char *filename) {
         return NULL;
     }
     handle->ownership = true;
+    handle->library = library->library;
+    handle->filename = filename;
     return handle;
 }
 
@@ -137,10 +180,15 @@ FontHandle * loadFontData(FreetypeHandle *library, const byte *data, int length)
         return NULL;
     }
     handle->ownership = true;
+    handle->library = library->library;
+    handle->data = data;
+    handle->length = length;
     return handle;
 }
 
 void destroyFont(FontHandle *font) {
+    for (std::vector<FT_Face>::iterator glyphFace = font->glyphFaces.begin(); glyphFace != font->glyphFaces.end(); ++glyphFace)
+        FT_Done_Face(*glyphFace);
     if (font->ownership)
         FT_Done_Face(font->face);
     delete font;
@@ -173,16 +221,49 @@ bool getGlyphIndex(GlyphIndex &glyphIndex, FontHandle *font, unicode_t unicode)
     return glyphIndex.getIndex() != 0;
 }
 
-bool loadGlyph(Shape &output, FontHandle *font, GlyphIndex glyphIndex, double *advance) {
-    if (!font)
-        return false;
-    FT_Error error = FT_Load_Glyph(font->face, glyphIndex.getIndex(), FT_LOAD_NO_SCALE);
+static FT_Face acquireGlyphFace(FontHandle *font) {
+    if (!font->library) {
+        font->faceMutex.lock();
+        return font->face;
+    }
+    std::lock_guard<std::mutex> lock(font->faceMutex);
+    if (!font->idleFaces.empty()) {
+        FT_Face face = font->idleFaces.back();
+        font->idleFaces.pop_back();
+        return face;
+    }
+    FT_Face face = NULL;
+    FT_Error error = font->data ? FT_New_Memory_Face(font->library, font->data, font->length, 0, &face) : FT_New_Face(font->library, font->filename.c_str(), 0, &face);
+    if (error)
+        return NULL;
+    font->glyphFaces.push_back(face);
+    return face;
+}
+
+static void releaseGlyphFace(FontHandle *font, FT_Face face) {
+    if (!font->library) {
+        font->faceMutex.unlock();
+        return;
+    }
+    if (face) {
+        std::lock_guard<std::mutex> lock(font->faceMutex);
+        font->idleFaces.push_back(face);
+    }
+}
+
+static void cacheGlyph(FontHandle *font, GlyphIndex glyphIndex, const Shape &shape, double advance) {
+    CachedGlyph glyph = { SharedShape(shape), advance };
+    std::lock_guard<std::mutex> lock(font->glyphCacheMutex);
+    font->glyphCache.insert(std::make_pair(glyphIndex.getIndex(), glyph));
+}
+
+static bool decodeGlyph(Shape &output, double &advance, FT_Face face, GlyphIndex glyphIndex) {
+    FT_Error error = FT_Load_Glyph(face, glyphIndex.getIndex(), FT_LOAD_NO_SCALE);
     if (error)
         return false;
     output.contours.clear();
     output.inverseYAxis = false;
-    if (advance)
-        *advance = F26DOT6_TO_DOUBLE(font->face->glyph->advance.x);
+    advance = F26DOT6_TO_DOUBLE(face->glyph->advance.x);
 
     FtContext context = { };
     context.shape = &output;
@@ -193,7 +274,7 @@ bool loadGlyph(Shape &output, FontHandle *font, GlyphIndex glyphIndex, double *a
     ftFunctions.cubic_to = &ftCubicTo;
     ftFunctions.shift = 0;
     ftFunctions.delta = 0;
-    error = FT_Outline_Decompose(&font->face->glyph->outline, &ftFunctions, &context);
+    error = FT_Outline_Decompose(&face->glyph->outline, &ftFunctions, &context);
     if (error)
         return false;
     if (!output.contours.empty() && output.contours.back().edges.empty())
@@ -201,8 +282,71 @@ bool loadGlyph(Shape &output, FontHandle *font, GlyphIndex glyphIndex, double *a
     return true;
 }
 
+static bool findCachedGlyph(Shape &output, double *advance, FontHandle *font, GlyphIndex glyphIndex) {
+    std::lock_guard<std::mutex> lock(font->glyphCacheMutex);
+    std::unordered_map<unsigned, CachedGlyph>::const_iterator cached = font->glyphCache.find(glyphIndex.getIndex());
+    if (cached == font->glyphCache.end())
+        return false;
+    output = *cached->second.shape;
+    if (advance)
+        *advance = cached->second.advance;
+    return true;
+}
+
+bool loadGlyph(Shape &output, FontHandle *font, GlyphIndex glyphIndex, double *advance) {
+    if (!font)
+        return false;
+    if (findCachedGlyph(output, advance, font, glyphIndex))
+        return true;
+
+    // Threads that miss the cache for the same glyph at once each decode it, and the first one to finish is kept
+    double glyphAdvance = 0;
+    FT_Face face = acquireGlyphFace(font);
+    bool decoded = face && decodeGlyph(output, glyphAdvance, face, glyphIndex);
+    releaseGlyphFace(font, face);
+    if (!decoded)
+        return false;
+    cacheGlyph(font, glyphIndex, output, glyphAdvance);
+    if (advance)
+        *advance = glyphAdvance;
+    return true;
+}
+
 bool loadGlyph(Shape &output, FontHandle *font, unicode_t unicode, double *advance) {
-    return loadGlyph(output, font, GlyphIndex(FT_Get_Char_Index(font->face, unicode)), advance);
+    if (!font)
+        return false;
+    {
+        std::unique_lock<std::mutex> lock(font->glyphCacheMutex);
+        std::unordered_map<unicode_t, unsigned>::const_iterator charIndex = font->charIndices.find(unicode);
+        if (charIndex != font->charIndices.end()) {
+            GlyphIndex glyphIndex(charIndex->second);
+            lock.unlock();
+            return loadGlyph(output, font, glyphIndex, advance);
+        }
+    }
+
+    // A new character's index is looked up with the same face that decodes its glyph, so it is only acquired once
+    double glyphAdvance = 0;
+    FT_Face face = acquireGlyphFace(font);
+    if (!face) {
+        releaseGlyphFace(font, face);
+        return false;
+    }
+    GlyphIndex glyphIndex(FT_Get_Char_Index(face, unicode));
+    bool cached = findCachedGlyph(output, &glyphAdvance, font, glyphIndex);
+    bool decoded = cached || decodeGlyph(output, glyphAdvance, face, glyphIndex);
+    releaseGlyphFace(font, face);
+    {
+        std::lock_guard<std::mutex> lock(font->glyphCacheMutex);
+        font->charIndices.insert(std::make_pair(unicode, glyphIndex.getIndex()));
+    }
+    if (!decoded)
+        return false;
+    if (!cached)
+        cacheGlyph(font, glyphIndex, output, glyphAdvance);
+    if (advance)
+        *advance = glyphAdvance;
+    return true;
 }
 
 bool getKerning(double &output, FontHandle *font, GlyphIndex glyphIndex1, GlyphIndex glyphIndex2) {
@@ -219,4 +363,35 @@ bool getKerning(double &output, FontHandle *font, unicode_t unicode1, unicode_t
     return getKerning(output, font, GlyphIndex(FT_Get_Char_Index(font->face, unicode1)), GlyphIndex(FT_Get_Char_Index(font->face, unicode2)));
 }
 
+static unsigned readUint16(const FT_Byte *data) {
+    return (unsigned) data[0]<<8|data[1];
+}
+
+bool getKerningPairs(std::vector<std::pair<GlyphIndex, GlyphIndex> > &output, FontHandle *font) {
+    output.clear();
+    if (!font || !FT_IS_SFNT(font->face))
+        return false;
+    FT_ULong length = 0;
+    if (FT_Load_Sfnt_Table(font->face, TTAG_kern, 0, NULL, &length) || length < 4)
+        return true;
+    std::vector<FT_Byte> table(length);
+    REQUIRE(!FT_Load_Sfnt_Table(font->face, TTAG_kern, 0, &table[0], &length));
+    // Subtables are read the way FreeType reads them for FT_Get_Kerning - only horizontal ones, without minimum values, are applied
+    size_t subtable = 4;
+    for (unsigned i = 0, subtableCount = readUint16(&table[2]); i < subtableCount && subtable+6 <= length; ++i) {
+        size_t subtableLength = readUint16(&table[subtable+2]);
+        unsigned coverage = readUint16(&table[subtable+4]);
+        if (subtableLength <= 14)
+            break;
+        size_t subtableEnd = min(subtable+subtableLength, (size_t) length);
+        if ((coverage&3) == 1 && subtable+14 <= subtableEnd) {
+            size_t pairCount = min((size_t) readUint16(&table[subtable+6]), (subtableEnd-subtable-14)/6);
+            for (const FT_Byte *pair = &table[subtable+14], *end = pair+6*pairCount; pair < end; pair += 6)
+                output.push_back(std::make_pair(GlyphIndex(readUint16(pair)), GlyphIndex(readUint16(pair+2))));
+        }
+        subtable = subtableEnd;
+    }
+    return true;
+}
+
 }
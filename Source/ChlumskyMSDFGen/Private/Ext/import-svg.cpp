@@ -3,11 +3,31 @@
 #include "import-svg.h"
 
 #include <cstdio>
-#include <3rdParty/tinyxml2.h>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "arithmetics.hpp"
+#include "resolve-shape-geometry.h"
+#include "Async/ParallelFor.h"
 
-#define ARC_SEGMENTS_PER_PI 2
+// Radial error of arc approximations relative to the radius when no tolerance is given, which allows quarter-circle segments
+#define DEFAULT_ARC_RELATIVE_ERROR 3e-4
+#define MAX_ARC_SEGMENTS 64
 #define ENDPOINT_SNAP_RANGE_PROPORTION (1/16384.)
+// When elements are resolved, those with up to this many edges are resolved on their own before they are placed, larger ones are only oriented by their total area
+#define SVG_RESOLVE_ELEMENT_EDGES 4096
+// Limit of nested <use> references, which also stops reference cycles
+#define MAX_USE_DEPTH 16
+// Limit of edges placed by all instances together, each counting as at least one, so that <use> fan-out can't exhaust memory
+#define MAX_PLACED_EDGES 4194304
+// Files are read in chunks of this size
+#define SVG_FILE_CHUNK_SIZE 262144
+// Shape elements are built in parallel once this many are queued, or once the copies of their text reach the size
+#define SVG_BATCH_SHAPES 1024
+#define SVG_BATCH_TEXT_SIZE 4194304
+#define SVG_PENDING_TEXT_BLOCK_SIZE 262144
 
 #ifndef M_PI
 #define M_PI       3.14159265358979323846   // pi
@@ -26,9 +46,9 @@ static void skipExtraChars(const char *&pathDef) {
         ++pathDef;
 }
 
-static bool readNodeType(char &output, const char *&pathDef) {
+static bool readNodeType(char &output, const char *&pathDef, const char *pathEnd) {
     skipExtraChars(pathDef);
-    char nodeType = *pathDef;
+    char nodeType = pathDef < pathEnd ? *pathDef : '\0';
     if (nodeType && nodeType != '+' && nodeType != '-' && nodeType != '.' && nodeType != ',' && (nodeType < '0' || nodeType > '9')) {
         ++pathDef;
         output = nodeType;
@@ -37,58 +57,189 @@ static bool readNodeType(char &output, const char *&pathDef) {
     return false;
 }
 
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/// Exact powers of ten, used to scale mantissas that fit into a double without rounding.
+static const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/// Reads a number as defined by the SVG path grammar, independently of the C locale.
+/// A number ends at the first character that cannot continue it, so compact forms like "1.5.5" (1.5, .5) and "-1-2" (-1, -2) are split correctly.
+/// The result is exact if it has at most 15 significant digits and a decimal exponent within 22, which covers practically all path data.
+static bool readNumber(double &output, const char *&pathDef) {
+    const char *cur = pathDef;
+    bool negative = false;
+    if (*cur == '+' || *cur == '-')
+        negative = *cur++ == '-';
+    unsigned long long mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool anyDigits = false;
+    for (; isDigit(*cur); ++cur) {
+        anyDigits = true;
+        // Digits beyond what the mantissa can hold only affect the exponent
+        if (digits < 19) {
+            mantissa = 10*mantissa+(*cur-'0');
+            digits += mantissa > 0;
+        } else
+            ++exponent;
+    }
+    if (*cur == '.') {
+        ++cur;
+        for (; isDigit(*cur); ++cur) {
+            anyDigits = true;
+            if (digits < 19) {
+                mantissa = 10*mantissa+(*cur-'0');
+                digits += mantissa > 0;
+                --exponent;
+            }
+        }
+    }
+    if (!anyDigits)
+        return false;
+    if (*cur == 'e' || *cur == 'E') {
+        const char *exponentStart = cur+1;
+        bool negativeExponent = false;
+        if (*exponentStart == '+' || *exponentStart == '-')
+            negativeExponent = *exponentStart++ == '-';
+        // Otherwise the 'e' is not part of the number
+        if (isDigit(*exponentStart)) {
+            int explicitExponent = 0;
+            for (cur = exponentStart; isDigit(*cur); ++cur)
+                explicitExponent = min(10*explicitExponent+(*cur-'0'), 100000);
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        }
+    }
+    double value = (double) mantissa;
+    if (exponent < 0 && exponent >= -22 && mantissa < 1ull<<53)
+        value /= POWERS_OF_TEN[-exponent];
+    else if (exponent >= 0 && exponent <= 22 && mantissa < 1ull<<53)
+        value *= POWERS_OF_TEN[exponent];
+    else if (mantissa)
+        value *= pow(10., exponent);
+    output = negative ? -value : value;
+    pathDef = cur;
+    return true;
+}
+
 static bool readCoord(Point2 &output, const char *&pathDef) {
     skipExtraChars(pathDef);
-    int shift;
+    const char *cur = pathDef;
     double x, y;
-    
-#ifdef MSDFGEN_USE_CRT_SECURE
-    if (sscanf_s(pathDef, "%lf%lf%n", &x, &y, &shift) == 2 || sscanf_s(pathDef, "%lf , %lf%n", &x, &y, &shift) == 2) {
-#else
-    if (sscanf(pathDef, "%lf%lf%n", &x, &y, &shift) == 2 || sscanf(pathDef, "%lf , %lf%n", &x, &y, &shift) == 2) {
-#endif
-        output.x = x;
-        output.y = y;
-        pathDef += shift;
-        return true;
+    if (readNumber(x, cur)) {
+        skipExtraChars(cur);
+        if (readNumber(y, cur)) {
+            output.x = x;
+            output.y = y;
+            pathDef = cur;
+            return true;
+        }
     }
     return false;
 }
 
 static bool readDouble(double &output, const char *&pathDef) {
     skipExtraChars(pathDef);
-    int shift;
-    double v;
-        
-#ifdef MSDFGEN_USE_CRT_SECURE
-    if (sscanf_s(pathDef, "%lf%n", &v, &shift) == 1) {
-#else
-    if (sscanf_s(pathDef, "%lf%n", &v, &shift) == 1) {
-#endif
-        pathDef += shift;
-        output = v;
-        return true;
-    }
-    return false;
+    return readNumber(output, pathDef);
 }
 
+/// Arc flags are single characters, so "011" is read as three separate flags.
 static bool readBool(bool &output, const char *&pathDef) {
     skipExtraChars(pathDef);
-    int shift;
-    int v;
-        
-#ifdef MSDFGEN_USE_CRT_SECURE
-    if (sscanf_s(pathDef, "%d%n", &v, &shift) == 1) {
-#else
-    if (sscanf_s(pathDef, "%d%n", &v, &shift) == 1) {
-#endif
-        pathDef += shift;
-        output = v != 0;
+    if (*pathDef == '0' || *pathDef == '1') {
+        output = *pathDef++ == '1';
         return true;
     }
     return false;
 }
 
+/// Affine transformation mapping (x, y) to (a*x+c*y+e, b*x+d*y+f), with the coefficients in the order of the SVG matrix() function.
+struct SvgTransform {
+    double a, b, c, d, e, f;
+
+    explicit SvgTransform(double a = 1, double b = 0, double c = 0, double d = 1, double e = 0, double f = 0) : a(a), b(b), c(c), d(d), e(e), f(f) { }
+
+    Point2 operator()(Point2 p) const {
+        return Point2(a*p.x+c*p.y+e, b*p.x+d*p.y+f);
+    }
+
+    bool isIdentity() const {
+        return a == 1 && b == 0 && c == 0 && d == 1 && e == 0 && f == 0;
+    }
+
+    /// Returns whether the transformation mirrors the geometry, which reverses the winding of its contours.
+    bool isMirror() const {
+        return a*d-b*c < 0;
+    }
+
+    /// Returns the largest factor by which the transformation scales any distance.
+    double maxScale() const {
+        double squareSum = a*a+b*b+c*c+d*d, determinant = a*d-b*c;
+        return sqrt(.5*(squareSum+sqrt(max(squareSum*squareSum-4*determinant*determinant, 0.))));
+    }
+
+    /// Returns the transformation that applies other first, then this one.
+    SvgTransform operator*(const SvgTransform &other) const {
+        return SvgTransform(
+            a*other.a+c*other.b, b*other.a+d*other.b,
+            a*other.c+c*other.d, b*other.c+d*other.d,
+            a*other.e+c*other.f+e, b*other.e+d*other.f+f
+        );
+    }
+};
+
+static bool isTransformNameChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+/// Reads a transform list such as "translate(10 20) rotate(45)", composing its transformations from left to right.
+static bool readTransform(SvgTransform &output, const char *cur, const char *end) {
+    SvgTransform transform;
+    while (true) {
+        skipExtraChars(cur);
+        if (cur >= end)
+            break;
+        const char *nameStart = cur;
+        while (cur < end && isTransformNameChar(*cur))
+            ++cur;
+        size_t nameLength = cur-nameStart;
+        skipExtraChars(cur);
+        REQUIRE(cur < end && *cur == '(');
+        ++cur;
+        double args[6];
+        int argCount = 0;
+        while (argCount < 6 && readDouble(args[argCount], cur))
+            ++argCount;
+        skipExtraChars(cur);
+        REQUIRE(cur < end && *cur == ')');
+        ++cur;
+        #define TRANSFORM_NAME_IS(name) (nameLength == sizeof(name)-1 && !memcmp(nameStart, name, nameLength))
+        if (TRANSFORM_NAME_IS("matrix") && argCount == 6)
+            transform = transform*SvgTransform(args[0], args[1], args[2], args[3], args[4], args[5]);
+        else if (TRANSFORM_NAME_IS("translate") && argCount <= 2 && argCount >= 1)
+            transform = transform*SvgTransform(1, 0, 0, 1, args[0], argCount > 1 ? args[1] : 0);
+        else if (TRANSFORM_NAME_IS("scale") && argCount <= 2 && argCount >= 1)
+            transform = transform*SvgTransform(args[0], 0, 0, argCount > 1 ? args[1] : args[0]);
+        else if (TRANSFORM_NAME_IS("rotate") && (argCount == 1 || argCount == 3)) {
+            double angle = args[0]*M_PI/180, cosAngle = cos(angle), sinAngle = sin(angle);
+            // Rotation about (cx, cy) is translate(cx, cy) rotate(angle) translate(-cx, -cy)
+            Point2 center = argCount == 3 ? Point2(args[1], args[2]) : Point2();
+            transform = transform*SvgTransform(cosAngle, sinAngle, -sinAngle, cosAngle, center.x-cosAngle*center.x+sinAngle*center.y, center.y-sinAngle*center.x-cosAngle*center.y);
+        } else if (TRANSFORM_NAME_IS("skewX") && argCount == 1)
+            transform = transform*SvgTransform(1, 0, tan(args[0]*M_PI/180), 1);
+        else if (TRANSFORM_NAME_IS("skewY") && argCount == 1)
+            transform = transform*SvgTransform(1, tan(args[0]*M_PI/180), 0, 1);
+        else
+            REQUIRE(!"Unknown transform");
+        #undef TRANSFORM_NAME_IS
+    }
+    output = transform;
+    return true;
+}
+
 static double arcAngle(Vector2 u, Vector2 v) {
     return nonZeroSign(crossProduct(u, v))*acos(clamp(dotProduct(u, v)/(u.length()*v.length()), -1., +1.));
 }
@@ -97,11 +248,48 @@ static Vector2 rotateVector(Vector2 v, Vector2 direction) {
     return Vector2(direction.x*v.x-direction.y*v.y, direction.y*v.x+direction.x*v.y);
 }
 
-static void addArcApproximate(Contour &contour, Point2 startPoint, Point2 endPoint, Vector2 radius, double rotation, bool largeArc, bool sweep) {
+/// Returns an upper bound of the radial error of a cubic segment approximating an arc of a unit circle spanning angle, with handles of length 4/3*tan(angle/4).
+/// The bound is tight - for a quarter circle it is 0.02726%, only about 0.01% more than the measured maximum error of 0.02725%.
+static double arcSegmentError(double angle) {
+    double s = sin(.25*angle), c = cos(.25*angle);
+    return 2/27.*s*s*s*s*s*s/(c*c);
+}
+
+/// Adds cubic segments approximating the arc of an ellipse with the given center, radii and axis direction from angleStart by angleExtent, mapped by transform.
+/// The arc is split into as few segments of equal angle as keep their radial error within tolerance, given in user space,
+/// so small arcs are a single segment. The segments are joined exactly at startPoint and endPoint.
+static void addEllipticArc(Contour &contour, const SvgTransform &transform, Point2 center, Vector2 radius, Vector2 axis, double angleStart, double angleExtent, double tolerance, Point2 startPoint, Point2 endPoint) {
+    // The circle approximation is mapped to the ellipse affinely, so its error is at most scaled by the larger radius
+    double relativeTolerance = tolerance > 0 ? tolerance/max(radius.x, radius.y) : DEFAULT_ARC_RELATIVE_ERROR;
+    // One segment can span at most half a circle. The estimate from the leading term of the error bound is refined upwards.
+    int segments = max((int) ceil(fabs(angleExtent)/M_PI), (int) ceil(fabs(angleExtent)/(4*pow(13.5*relativeTolerance, 1/6.))));
+    segments = min(max(segments, 1), MAX_ARC_SEGMENTS);
+    while (segments < MAX_ARC_SEGMENTS && arcSegmentError(fabs(angleExtent)/segments) > relativeTolerance)
+        ++segments;
+    double angleIncrement = angleExtent/segments;
+    double cl = 4/3.*sin(.5*angleIncrement)/(1+cos(.5*angleIncrement));
+
+    Point2 prevNode = startPoint;
+    double angle = angleStart;
+    for (int i = 0; i < segments; ++i) {
+        Point2 controlPoint[2];
+        Vector2 d(cos(angle), sin(angle));
+        controlPoint[0] = center+rotateVector(Vector2(d.x-cl*d.y, d.y+cl*d.x)*radius, axis);
+        angle += angleIncrement;
+        d.set(cos(angle), sin(angle));
+        controlPoint[1] = center+rotateVector(Vector2(d.x+cl*d.y, d.y-cl*d.x)*radius, axis);
+        Point2 node = i == segments-1 ? endPoint : center+rotateVector(d*radius, axis);
+        contour.addEdge(EdgeHolder(transform(prevNode), transform(controlPoint[0]), transform(controlPoint[1]), transform(node)));
+        prevNode = node;
+    }
+}
+
+/// Approximates an SVG arc given in user space with cubic segments within tolerance, which are added to contour mapped by transform.
+static void addArcApproximate(Contour &contour, const SvgTransform &transform, Point2 startPoint, Point2 endPoint, Vector2 radius, double rotation, bool largeArc, bool sweep, double tolerance) {
     if (endPoint == startPoint)
         return;
     if (radius.x == 0 || radius.y == 0)
-        return contour.addEdge(new LinearSegment(startPoint, endPoint));
+        return contour.addEdge(EdgeHolder(transform(startPoint), transform(endPoint)));
 
     radius.x = fabs(radius.x);
     radius.y = fabs(radius.y);
@@ -128,31 +316,20 @@ static void addArcApproximate(Contour &contour, Point2 startPoint, Point2 endPoi
     else if (sweep && angleExtent < 0)
         angleExtent += 2*M_PI;
 
-    int segments = (int) ceil(ARC_SEGMENTS_PER_PI/M_PI*fabs(angleExtent));
-    double angleIncrement = angleExtent/segments;
-    double cl = 4/3.*sin(.5*angleIncrement)/(1+cos(.5*angleIncrement));
-
-    Point2 prevNode = startPoint;
-    double angle = angleStart;
-    for (int i = 0; i < segments; ++i) {
-        Point2 controlPoint[2];
-        Vector2 d(cos(angle), sin(angle));
-        controlPoint[0] = center+rotateVector(Vector2(d.x-cl*d.y, d.y+cl*d.x)*radius, axis);
-        angle += angleIncrement;
-        d.set(cos(angle), sin(angle));
-        controlPoint[1] = center+rotateVector(Vector2(d.x+cl*d.y, d.y-cl*d.x)*radius, axis);
-        Point2 node = i == segments-1 ? endPoint : center+rotateVector(d*radius, axis);
-        contour.addEdge(new CubicSegment(prevNode, controlPoint[0], controlPoint[1], node));
-        prevNode = node;
-    }
+    addEllipticArc(contour, transform, center, radius, axis, angleStart, angleExtent, tolerance, startPoint, endPoint);
 }
 
-bool buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSnapRange) {
+/// Builds a shape from path data ending at pathEnd, which need not be null-terminated.
+/// The character at pathEnd must not continue a number or separator, e.g. a closing quote or a null character.
+/// Control points are mapped by transform as the segments are created, and endpointSnapRange and arcTolerance apply to the mapped points.
+static bool buildShapeFromSvgPath(Shape &shape, const SvgTransform &transform, const char *pathDef, const char *pathEnd, double endpointSnapRange, double arcTolerance) {
+    double transformScale = transform.maxScale();
+    double userArcTolerance = transformScale > 0 ? arcTolerance/transformScale : 0;
     char nodeType = '\0';
     char prevNodeType = '\0';
     Point2 prevNode(0, 0);
     bool nodeTypePreread = false;
-    while (nodeTypePreread || readNodeType(nodeType, pathDef)) {
+    while (nodeTypePreread || readNodeType(nodeType, pathDef, pathEnd)) {
         nodeTypePreread = false;
         Contour &contour = shape.addContour();
         bool contourStart = true;
@@ -161,7 +338,7 @@ bool buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSna
         Point2 controlPoint[2];
         Point2 node;
 
-        while (*pathDef) {
+        while (pathDef < pathEnd) {
             switch (nodeType) {
                 case 'M': case 'm':
                     if (!contourStart) {
@@ -181,19 +358,19 @@ bool buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSna
                     REQUIRE(readCoord(node, pathDef));
                     if (nodeType == 'l')
                         node += prevNode;
-                    contour.addEdge(new LinearSegment(prevNode, node));
+                    contour.addEdge(EdgeHolder(transform(prevNode), transform(node)));
                     break;
                 case 'H': case 'h':
                     REQUIRE(readDouble(node.x, pathDef));
                     if (nodeType == 'h')
                         node.x += prevNode.x;
-                    contour.addEdge(new LinearSegment(prevNode, node));
+                    contour.addEdge(EdgeHolder(transform(prevNode), transform(node)));
                     break;
                 case 'V': case 'v':
                     REQUIRE(readDouble(node.y, pathDef));
                     if (nodeType == 'v')
                         node.y += prevNode.y;
-                    contour.addEdge(new LinearSegment(prevNode, node));
+                    contour.addEdge(EdgeHolder(transform(prevNode), transform(node)));
                     break;
                 case 'Q': case 'q':
                     REQUIRE(readCoord(controlPoint[0], pathDef));
@@ -202,7 +379,7 @@ bool buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSna
                         controlPoint[0] += prevNode;
                         node += prevNode;
                     }
-                    contour.addEdge(new QuadraticSegment(prevNode, controlPoint[0], node));
+                    contour.addEdge(EdgeHolder(transform(prevNode), transform(controlPoint[0]), transform(node)));
                     break;
                 case 'T': case 't':
                     if (prevNodeType == 'Q' || prevNodeType == 'q' || prevNodeType == 'T' || prevNodeType == 't')
@@ -212,7 +389,7 @@ bool buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSna
                     REQUIRE(readCoord(node, pathDef));
                     if (nodeType == 't')
                         node += prevNode;
-                    contour.addEdge(new QuadraticSegment(prevNode, controlPoint[0], node));
+                    contour.addEdge(EdgeHolder(transform(prevNode), transform(controlPoint[0]), transform(node)));
                     break;
                 case 'C': case 'c':
                     REQUIRE(readCoord(controlPoint[0], pathDef));
@@ -223,7 +400,7 @@ bool buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSna
                         controlPoint[1] += prevNode;
                         node += prevNode;
                     }
-                    contour.addEdge(new CubicSegment(prevNode, controlPoint[0], controlPoint[1], node));
+                    contour.addEdge(EdgeHolder(transform(prevNode), transform(controlPoint[0]), transform(controlPoint[1]), transform(node)));
                     break;
                 case 'S': case 's':
                     if (prevNodeType == 'C' || prevNodeType == 'c' || prevNodeType == 'S' || prevNodeType == 's')
@@ -236,7 +413,7 @@ bool buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSna
                         controlPoint[1] += prevNode;
                         node += prevNode;
                     }
-                    contour.addEdge(new CubicSegment(prevNode, controlPoint[0], controlPoint[1], node));
+                    contour.addEdge(EdgeHolder(transform(prevNode), transform(controlPoint[0]), transform(controlPoint[1]), transform(node)));
                     break;
                 case 'A': case 'a':
                     {
@@ -252,7 +429,7 @@ bool buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSna
                         if (nodeType == 'a')
                             node += prevNode;
                         angle *= M_PI/180.0;
-                        addArcApproximate(contour, prevNode, node, radius, angle, largeArg, sweep);
+                        addArcApproximate(contour, transform, prevNode, node, radius, angle, largeArg, sweep, userArcTolerance);
                     }
                     break;
                 default:
@@ -261,7 +438,7 @@ bool buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSna
             contourStart &= nodeType == 'M' || nodeType == 'm';
             prevNode = node;
             prevNodeType = nodeType;
-            readNodeType(nodeType, pathDef);
+            readNodeType(nodeType, pathDef, pathEnd);
         }
     NEXT_CONTOUR:
         // Fix contour if it isn't properly closed
@@ -269,7 +446,7 @@ bool buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSna
             if ((contour.edges.back()->point(1)-contour.edges[0]->point(0)).length() < endpointSnapRange)
                 contour.edges.back()->moveEndPoint(contour.edges[0]->point(0));
             else
-                contour.addEdge(new LinearSegment(prevNode, startPoint));
+                contour.addEdge(EdgeHolder(transform(prevNode), transform(startPoint)));
         }
         prevNode = startPoint;
         prevNodeType = '\0';
@@ -277,69 +454,982 @@ bool buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSna
     return true;
 }
 
-static bool loadSvgFromXml(Shape &output, tinyxml2::XMLDocument& doc, int pathIndex, Vector2 *dimensions){
-    tinyxml2::XMLElement *root = doc.FirstChildElement("svg");
-    if (!root)
-        return false;
+bool buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSnapRange, double arcTolerance) {
+    return buildShapeFromSvgPath(shape, SvgTransform(), pathDef, pathDef+strlen(pathDef), endpointSnapRange, arcTolerance);
+}
 
-    tinyxml2::XMLElement *path = NULL;
-    if (pathIndex > 0) {
-        path = root->FirstChildElement("path");
-        if (!path) {
-            tinyxml2::XMLElement *g = root->FirstChildElement("g");
-            if (g)
-                path = g->FirstChildElement("path");
-        }
-        while (path && --pathIndex > 0)
-            path = path->NextSiblingElement("path");
-    } else {
-        path = root->LastChildElement("path");
-        if (!path) {
-            tinyxml2::XMLElement *g = root->LastChildElement("g");
-            if (g)
-                path = g->LastChildElement("path");
+/// A range of the input text. It is not null-terminated.
+struct TextRange {
+    const char *begin, *end;
+
+    bool operator==(const char *text) const {
+        size_t length = strlen(text);
+        return (size_t) (end-begin) == length && !memcmp(begin, text, length);
+    }
+};
+
+struct XmlAttribute {
+    TextRange name, value;
+};
+
+/// The start tag of an element, referencing its name and attributes in the input text without copying them.
+struct XmlElement {
+    /// Local name, without any namespace prefix.
+    TextRange name;
+    const XmlAttribute *attributes;
+    int attributeCount;
+
+    /// Returns the value of the attribute, or NULL if the element has none. The value is followed by its closing quote or a null character.
+    const TextRange * attribute(const char *attributeName) const {
+        for (int i = 0; i < attributeCount; ++i)
+            if (attributes[i].name == attributeName)
+                return &attributes[i].value;
+        return NULL;
+    }
+};
+
+static const char * findText(const char *cur, const char *end, const char *text) {
+    size_t length = strlen(text);
+    for (; (size_t) (end-cur) >= length; ++cur) {
+        cur = (const char *) memchr(cur, *text, end-cur);
+        if (!cur || (size_t) (end-cur) < length)
+            return NULL;
+        if (!memcmp(cur, text, length))
+            return cur;
+    }
+    return NULL;
+}
+
+static bool isXmlSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool isXmlNameEnd(char c) {
+    return isXmlSpace(c) || c == '/' || c == '>' || c == '=';
+}
+
+static TextRange localName(TextRange name) {
+    if (const char *colon = (const char *) memchr(name.begin, ':', name.end-name.begin))
+        name.begin = colon+1;
+    return name;
+}
+
+/// Receives the elements of a document from an XmlReader in document order.
+class XmlHandler {
+
+public:
+    virtual ~XmlHandler() { }
+    /// Called for the start tag of every element. The text of the element is only valid during the call, unless the whole document is read at once.
+    virtual bool startElement(const XmlElement &element) = 0;
+    /// Called at the end of every element, including empty ones.
+    virtual bool endElement() = 0;
+
+};
+
+/// Reads the markup of an XML document as it arrives and passes its elements to a handler, without copying or modifying the text.
+/// Text content, comments, CDATA sections, processing instructions and the document type declaration are skipped, and entities are left undecoded.
+/// Other than the text passed to it, the reader only holds the names of the open elements.
+class XmlReader {
+
+public:
+    explicit XmlReader(XmlHandler &handler) : handler(handler) { }
+    /// Reads the complete pieces of markup at the start of text and stores their length in consumed.
+    /// The rest, which is at most one unfinished piece of markup, must be passed again at the start of the next call.
+    /// If last is set, text must finish the document. Returns false if the markup is malformed or the handler fails.
+    bool read(const char *text, size_t length, bool last, size_t &consumed);
+
+private:
+    XmlHandler &handler;
+    std::vector<XmlAttribute> attributes;
+    /// Local names of the open elements, for matching end tags.
+    std::string openNames;
+    std::vector<size_t> openNameStarts;
+
+};
+
+bool XmlReader::read(const char *text, size_t length, bool last, size_t &consumed) {
+    const char *cur = text, *end = text+length, *markup;
+    // An unfinished piece of markup is left for the next call, unless the document ends there
+    #define XML_UNFINISHED() { if (last) return false; consumed = markup-text; return true; }
+    while ((markup = (const char *) memchr(cur, '<', end-cur))) {
+        cur = markup+1;
+        // Wait for enough text to tell the kinds of markup starting with '!' apart
+        if (!last && (cur >= end || (*cur == '!' && end-cur < 8)))
+            XML_UNFINISHED();
+        if (end-cur >= 3 && !memcmp(cur, "!--", 3)) {
+            if (!(cur = findText(cur+3, end, "-->")))
+                XML_UNFINISHED();
+            cur += 3;
+        } else if (end-cur >= 8 && !memcmp(cur, "![CDATA[", 8)) {
+            if (!(cur = findText(cur+8, end, "]]>")))
+                XML_UNFINISHED();
+            cur += 3;
+        } else if (cur < end && *cur == '!') {
+            // Document type declaration, which may contain an internal subset in brackets
+            int depth = 0;
+            for (; cur < end && (*cur != '>' || depth > 0); ++cur)
+                depth += *cur == '[' ? 1 : *cur == ']' ? -1 : 0;
+            if (cur >= end)
+                XML_UNFINISHED();
+            ++cur;
+        } else if (cur < end && *cur == '?') {
+            if (!(cur = findText(cur+1, end, "?>")))
+                XML_UNFINISHED();
+            cur += 2;
+        } else if (cur < end && *cur == '/') {
+            const char *nameStart = ++cur;
+            while (cur < end && !isXmlNameEnd(*cur))
+                ++cur;
+            const char *tagEnd = (const char *) memchr(cur, '>', end-cur);
+            if (!tagEnd)
+                XML_UNFINISHED();
+            TextRange name = { nameStart, cur };
+            name = localName(name);
+            if (openNameStarts.empty() || openNames.compare(openNameStarts.back(), std::string::npos, name.begin, name.end-name.begin))
+                return false;
+            openNames.resize(openNameStarts.back());
+            openNameStarts.pop_back();
+            if (!handler.endElement())
+                return false;
+            cur = tagEnd+1;
+        } else {
+            XmlElement element;
+            element.name.begin = cur;
+            while (cur < end && !isXmlNameEnd(*cur))
+                ++cur;
+            element.name.end = cur;
+            if (cur >= end)
+                XML_UNFINISHED();
+            if (element.name.begin == element.name.end)
+                return false;
+            element.name = localName(element.name);
+            attributes.clear();
+            bool selfClosing = false;
+            while (true) {
+                while (cur < end && isXmlSpace(*cur))
+                    ++cur;
+                if (cur >= end)
+                    XML_UNFINISHED();
+                if (*cur == '>') {
+                    ++cur;
+                    break;
+                }
+                if (*cur == '/') {
+                    if (++cur >= end)
+                        XML_UNFINISHED();
+                    if (*cur != '>')
+                        return false;
+                    ++cur;
+                    selfClosing = true;
+                    break;
+                }
+                XmlAttribute attribute;
+                attribute.name.begin = cur;
+                while (cur < end && !isXmlNameEnd(*cur))
+                    ++cur;
+                attribute.name.end = cur;
+                while (cur < end && isXmlSpace(*cur))
+                    ++cur;
+                if (cur < end && *cur == '=')
+                    ++cur;
+                else if (cur < end || attribute.name.begin == attribute.name.end)
+                    return false;
+                while (cur < end && isXmlSpace(*cur))
+                    ++cur;
+                if (cur >= end)
+                    XML_UNFINISHED();
+                if (attribute.name.begin == attribute.name.end || (*cur != '"' && *cur != '\''))
+                    return false;
+                char quote = *cur++;
+                attribute.value.begin = cur;
+                if (!(cur = (const char *) memchr(cur, quote, end-cur)))
+                    XML_UNFINISHED();
+                attribute.value.end = cur++;
+                attributes.push_back(attribute);
+            }
+            element.attributes = attributes.data();
+            element.attributeCount = (int) attributes.size();
+            if (!handler.startElement(element))
+                return false;
+            if (selfClosing) {
+                if (!handler.endElement())
+                    return false;
+            } else {
+                openNameStarts.push_back(openNames.size());
+                openNames.append(element.name.begin, element.name.end);
+            }
         }
-        while (path && ++pathIndex < 0)
-            path = path->PreviousSiblingElement("path");
     }
-    if (!path)
-        return false;
-    const char *pd = path->Attribute("d");
-    if (!pd)
+    #undef XML_UNFINISHED
+    consumed = length;
+    return !last || openNameStarts.empty();
+}
+
+/// Passes a document held in memory to handler.
+static bool readXml(XmlHandler &handler, const char *text, size_t length) {
+    XmlReader reader(handler);
+    size_t consumed;
+    return reader.read(text, length, true, consumed);
+}
+
+/// Passes a document to handler as it is read from a file in chunks.
+/// The buffer only grows beyond the chunk size to hold a single piece of markup that is larger.
+static bool readXmlFile(XmlHandler &handler, const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file)
         return false;
+    XmlReader reader(handler);
+    std::vector<char> buffer(SVG_FILE_CHUNK_SIZE);
+    size_t filled = 0;
+    bool result = true, last = false;
+    while (result && !last) {
+        if (filled == buffer.size())
+            buffer.resize(2*buffer.size());
+        filled += fread(buffer.data()+filled, 1, buffer.size()-filled, file);
+        // fread only returns less than requested at the end of the file
+        last = filled < buffer.size();
+        if (last && ferror(file))
+            result = false;
+        size_t consumed = 0;
+        result = result && reader.read(buffer.data(), filled, last, consumed);
+        memmove(buffer.data(), buffer.data()+consumed, filled-consumed);
+        filled -= consumed;
+    }
+    fclose(file);
+    return result;
+}
 
-    output.contours.clear();
-    output.inverseYAxis = true;
-    Vector2 dims(root->DoubleAttribute("width"), root->DoubleAttribute("height"));
-    if (!dims) {
-        double left, top;
-        const char *viewBox = root->Attribute("viewBox");
-        if (viewBox)
-#ifdef MSDFGEN_USE_CRT_SECURE
-        sscanf_s(viewBox, "%lf %lf %lf %lf", &left, &top, &dims.x, &dims.y);
-#else
-        sscanf(viewBox, "%lf %lf %lf %lf", &left, &top, &dims.x, &dims.y);
-#endif
+/// Reads a length attribute, ignoring any unit after the number, or returns 0 if there is none.
+static double readLength(const XmlElement &element, const char *name) {
+    double value = 0;
+    if (const TextRange *attribute = element.attribute(name)) {
+        const char *cur = attribute->begin;
+        if (!readDouble(value, cur))
+            value = 0;
     }
-    if (dimensions)
-        *dimensions = dims;
-    return buildShapeFromSvgPath(output, pd, ENDPOINT_SNAP_RANGE_PROPORTION*dims.length());       
+    return value;
+}
+
+/// Adds a rectangle with corners rounded to elliptic quarter arcs of the given radii, which may be zero.
+/// Sides shortened to nothing by the corners are left out, so an ellipse is made of just four cubic segments unless arcTolerance requires more.
+static void addRoundedRect(Shape &shape, const SvgTransform &transform, double x, double y, double width, double height, double rx, double ry, double arcTolerance) {
+    Contour &contour = shape.addContour();
+    Point2 sideEnds[8] = {
+        Point2(x+rx, y), Point2(x+width-rx, y),
+        Point2(x+width, y+ry), Point2(x+width, y+height-ry),
+        Point2(x+width-rx, y+height), Point2(x+rx, y+height),
+        Point2(x, y+height-ry), Point2(x, y+ry)
+    };
+    Point2 corners[4] = { Point2(x+width, y), Point2(x+width, y+height), Point2(x, y+height), Point2(x, y) };
+    double transformScale = transform.maxScale();
+    double userArcTolerance = transformScale > 0 ? arcTolerance/transformScale : 0;
+    for (int i = 0; i < 4; ++i) {
+        Point2 sideStart = sideEnds[2*i], sideEnd = sideEnds[2*i+1], nextSideStart = sideEnds[(2*i+2)%8];
+        if (sideStart != sideEnd)
+            contour.addEdge(EdgeHolder(transform(sideStart), transform(sideEnd)));
+        if (rx > 0 && ry > 0)
+            addEllipticArc(contour, transform, sideEnd+nextSideStart-corners[i], Vector2(rx, ry), Vector2(1, 0), (i-1)*.5*M_PI, .5*M_PI, userArcTolerance, sideEnd, nextSideStart);
+    }
+}
+
+/// Builds a <rect>, whose corner radii default to each other and are limited to half its size.
+static void buildShapeFromSvgRect(Shape &shape, const SvgTransform &transform, const XmlElement &element, double arcTolerance) {
+    double width = readLength(element, "width"), height = readLength(element, "height");
+    if (!(width > 0 && height > 0))
+        return;
+    double rx = readLength(element, "rx"), ry = readLength(element, "ry");
+    if (!element.attribute("rx"))
+        rx = ry;
+    if (!element.attribute("ry"))
+        ry = rx;
+    rx = clamp(rx, .5*width), ry = clamp(ry, .5*height);
+    if (!(rx > 0 && ry > 0))
+        rx = ry = 0;
+    addRoundedRect(shape, transform, readLength(element, "x"), readLength(element, "y"), width, height, rx, ry, arcTolerance);
+}
+
+static void buildShapeFromSvgEllipse(Shape &shape, const SvgTransform &transform, const XmlElement &element, bool circle, double arcTolerance) {
+    double rx = readLength(element, circle ? "r" : "rx"), ry = circle ? rx : readLength(element, "ry");
+    if (!(rx > 0 && ry > 0))
+        return;
+    double cx = readLength(element, "cx"), cy = readLength(element, "cy");
+    addRoundedRect(shape, transform, cx-rx, cy-ry, 2*rx, 2*ry, rx, ry, arcTolerance);
+}
+
+/// Builds a <polygon> or <polyline>. Both are filled as closed shapes, so they are built the same way.
+static void buildShapeFromSvgPolygon(Shape &shape, const SvgTransform &transform, const XmlElement &element) {
+    const TextRange *points = element.attribute("points");
+    if (!points)
+        return;
+    std::vector<Point2> vertices;
+    Point2 vertex;
+    for (const char *cur = points->begin; readCoord(vertex, cur); )
+        vertices.push_back(transform(vertex));
+    // Fewer vertices enclose no area
+    if (vertices.size() < 3)
+        return;
+    Contour &contour = shape.addContour();
+    contour.edges.reserve(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+        if (vertices[i] != vertices[(i+1)%vertices.size()])
+            contour.addEdge(EdgeHolder(vertices[i], vertices[(i+1)%vertices.size()]));
+}
+
+/// Checks whether an element describes filled geometry - a path or one of the basic shapes.
+/// <line> is left out, as it can only be stroked.
+static bool isSvgShape(const XmlElement &element) {
+    static const char *const SHAPES[] = { "path", "rect", "circle", "ellipse", "polygon", "polyline" };
+    for (int i = 0; i < (int) (sizeof(SHAPES)/sizeof(*SHAPES)); ++i)
+        if (element.name == SHAPES[i])
+            return true;
+    return false;
+}
+
+/// Builds the geometry of a single shape element, mapped from its user space by transform.
+/// Basic shapes are converted directly to their minimal set of segments.
+static bool buildShapeFromSvgElement(Shape &shape, const SvgTransform &transform, const XmlElement &element, double endpointSnapRange, double arcTolerance) {
+    const TextRange &name = element.name;
+    if (name == "path") {
+        if (const TextRange *pd = element.attribute("d"))
+            return buildShapeFromSvgPath(shape, transform, pd->begin, pd->end, endpointSnapRange, arcTolerance);
+    } else if (name == "rect")
+        buildShapeFromSvgRect(shape, transform, element, arcTolerance);
+    else if (name == "circle" || name == "ellipse")
+        buildShapeFromSvgEllipse(shape, transform, element, name == "circle", arcTolerance);
+    else if (name == "polygon" || name == "polyline")
+        buildShapeFromSvgPolygon(shape, transform, element);
+    return true;
+}
+
+static TextRange trimXmlSpace(const char *begin, const char *end) {
+    while (begin < end && isXmlSpace(*begin))
+        ++begin;
+    while (end > begin && isXmlSpace(end[-1]))
+        --end;
+    TextRange trimmed = { begin, end };
+    return trimmed;
+}
+
+/// Reads a property of an element from its style attribute, or failing that from its presentation attribute.
+static bool readProperty(TextRange &output, const XmlElement &element, const char *name) {
+    if (const TextRange *style = element.attribute("style")) {
+        for (const char *cur = style->begin; cur < style->end; ) {
+            const char *declarationEnd = (const char *) memchr(cur, ';', style->end-cur);
+            if (!declarationEnd)
+                declarationEnd = style->end;
+            if (const char *colon = (const char *) memchr(cur, ':', declarationEnd-cur)) {
+                if (trimXmlSpace(cur, colon) == name) {
+                    output = trimXmlSpace(colon+1, declarationEnd);
+                    return true;
+                }
+            }
+            cur = declarationEnd+1;
+        }
+    }
+    if (const TextRange *attribute = element.attribute(name)) {
+        output = trimXmlSpace(attribute->begin, attribute->end);
+        return true;
+    }
+    return false;
 }
-        
-bool loadSvgShape(Shape &output, const char *filename, int pathIndex, Vector2 *dimensions) {
-    tinyxml2::XMLDocument doc;
-    if (doc.LoadFile(filename))
+
+/// Checks whether an element and its children are left out of rendering by display="none" or zero opacity.
+/// A <symbol> is only ever rendered through references, which its display does not affect.
+static bool isHidden(const XmlElement &element) {
+    if (element.name == "symbol")
         return false;
+    TextRange value;
+    if (readProperty(value, element, "display") && value == "none")
+        return true;
+    if (readProperty(value, element, "opacity")) {
+        double opacity;
+        const char *cur = value.begin;
+        if (readNumber(opacity, cur) && opacity <= 0)
+            return true;
+    }
+    return false;
+}
+
+/// Checks whether an element's children are rendered as part of the document, rather than being definitions referenced from elsewhere.
+static bool isRenderedContainer(const XmlElement &element) {
+    static const char *const NON_RENDERED[] = { "defs", "clipPath", "mask", "symbol", "pattern", "marker", "linearGradient", "radialGradient", "filter", "style", "metadata" };
+    for (int i = 0; i < (int) (sizeof(NON_RENDERED)/sizeof(*NON_RENDERED)); ++i)
+        if (element.name == NON_RENDERED[i])
+            return false;
+    return true;
+}
 
-    return loadSvgFromXml(output, doc, pathIndex, dimensions);
+/// Reads an element's transform attribute. An invalid transform list is ignored, as it is by browsers.
+static SvgTransform readElementTransform(const XmlElement &element) {
+    SvgTransform transform;
+    if (const TextRange *attribute = element.attribute("transform"))
+        readTransform(transform, attribute->begin, attribute->end);
+    return transform;
+}
 
+static double readAlignment(const char *text) {
+    return !memcmp(text, "Min", 3) ? 0 : !memcmp(text, "Max", 3) ? 1 : .5;
 }
 
-bool buildShapeFromSvgFileBuffer(Shape &output, const char* file, size_t fileLength, int pathIndex, Vector2 *dimensions){
-    tinyxml2::XMLDocument doc;
-    if(doc.Parse(file, fileLength))
+/// Reads an element's viewBox attribute. Returns false if it has none, or it is invalid or empty.
+static bool readViewBox(Point2 &origin, Vector2 &size, const XmlElement &element) {
+    const TextRange *viewBox = element.attribute("viewBox");
+    if (!viewBox)
         return false;
+    const char *cur = viewBox->begin;
+    return readCoord(origin, cur) && readCoord(size, cur) && size.x > 0 && size.y > 0;
+}
+
+/// Reads the size of the root element and the transformation from its viewBox to that size.
+/// The viewBox is aligned and scaled as specified by preserveAspectRatio, by default uniformly to fit and centered.
+/// If the root has no width and height, its size is that of the viewBox.
+static Vector2 readSvgViewport(SvgTransform &viewBoxTransform, const XmlElement &root) {
+    Vector2 dims(readLength(root, "width"), readLength(root, "height"));
+    viewBoxTransform = SvgTransform();
+    Point2 origin;
+    Vector2 viewBoxSize;
+    if (!readViewBox(origin, viewBoxSize, root))
+        return dims;
+    if (!(dims.x > 0 && dims.y > 0)) {
+        viewBoxTransform = SvgTransform(1, 0, 0, 1, -origin.x, -origin.y);
+        return viewBoxSize;
+    }
+    Vector2 scale = dims/viewBoxSize;
+    Vector2 align(.5, .5);
+    bool uniform = true, slice = false;
+    if (const TextRange *aspectRatio = root.attribute("preserveAspectRatio")) {
+        const char *cur = aspectRatio->begin;
+        while (cur < aspectRatio->end && isXmlSpace(*cur))
+            ++cur;
+        if (aspectRatio->end-cur >= 4 && !memcmp(cur, "none", 4))
+            uniform = false;
+        else if (aspectRatio->end-cur >= 8 && cur[0] == 'x' && cur[4] == 'Y')
+            align.set(readAlignment(cur+1), readAlignment(cur+5));
+        slice = findText(cur, aspectRatio->end, "slice") != NULL;
+    }
+    if (uniform)
+        scale.x = scale.y = slice ? max(scale.x, scale.y) : min(scale.x, scale.y);
+    Vector2 offset = align*(dims-scale*viewBoxSize)-scale*origin;
+    viewBoxTransform = SvgTransform(scale.x, 0, 0, scale.y, offset.x, offset.y);
+    return dims;
+}
+
+/// Returns a copy of edge with its control points mapped by transform.
+static EdgeHolder transformEdge(const EdgeSegment *edge, const SvgTransform &transform) {
+    switch (edge->type) {
+        case EdgeSegment::SegmentType::Linear:
+            {
+                const Point2 *p = static_cast<const LinearSegment *>(edge)->p;
+                return EdgeHolder(transform(p[0]), transform(p[1]), edge->color);
+            }
+        case EdgeSegment::SegmentType::Quadratic:
+            {
+                const Point2 *p = static_cast<const QuadraticSegment *>(edge)->p;
+                return EdgeHolder(transform(p[0]), transform(p[1]), transform(p[2]), edge->color);
+            }
+        case EdgeSegment::SegmentType::Cubic:
+            {
+                const Point2 *p = static_cast<const CubicSegment *>(edge)->p;
+                return EdgeHolder(transform(p[0]), transform(p[1]), transform(p[2]), transform(p[3]), edge->color);
+            }
+        default:
+            return EdgeHolder();
+    }
+}
+
+/// A part of the geometry of a template - either a built shape element, or a <use> reference to the element with the given id.
+struct SvgPiece {
+    /// Index of the built shape, or -1 for a reference
+    int shape;
+    std::string reference;
+    /// Transformation relative to the template
+    SvgTransform transform;
+};
+
+/// The geometry of the document, or of an element referenced by <use>, which is kept separately and instanced for every reference.
+/// A referenced element's geometry is relative to its parent, so it includes the element's own transform.
+struct SvgTemplate {
+    std::vector<SvgPiece> pieces;
+    /// Largest scale of the template's instances, known when its elements are built
+    double scale;
+    /// The capture pass in which the template was first referenced
+    int requestPass;
+    bool captured, missing;
+
+    SvgTemplate() : scale(0), requestPass(0), captured(false), missing(false) { }
+};
+
+/// A shape element waiting to be built, and the range of its attributes in the batch.
+struct SvgPendingShape {
+    TextRange name;
+    int firstAttribute, attributeCount;
+    SvgTransform transform;
+    double arcTolerance;
+    int shape;
+};
+
+/// An open element, with the transformation of its user space and the template its geometry belongs to, if any.
+struct SvgOpenElement {
+    SvgTransform transform;
+    SvgTemplate *target;
+    bool childrenVisited;
+    /// Whether the element's child groups are sprites of a sprite sheet - true for the root and its <defs>
+    bool spriteContainer;
+    /// Whether the element is hidden by itself or an ancestor, so its shapes are not built
+    bool hidden;
+};
+
+/// A built shape placed in the document.
+struct SvgInstance {
+    int shape;
+    SvgTransform transform;
+};
+
+/// A sprite of a sprite sheet, whose geometry is captured as a template like a referenced element.
+struct SvgSpriteSource {
+    std::string id;
+    const SvgTemplate *source;
+    /// Maps the template into the sprite's own space - the inverse of the viewBox origin of a symbol
+    SvgTransform placement;
+    Vector2 dimensions;
+    bool viewBox;
+};
+
+/// Builds the geometry of an SVG document from its elements as they are read.
+/// The document is read once, which builds its shapes and notes the ids referenced by <use>.
+/// Referenced elements are then captured as templates by further passes, as they may appear anywhere, and instanced when the shape is assembled.
+/// Shape elements are queued with their attributes and built in parallel batches, so the memory held for them is bounded.
+/// For a sprite sheet, the document itself is not built, and each sprite is captured by the first pass instead.
+class SvgShapeReader : public XmlHandler {
+
+public:
+    /// If stableText is set, the document is read from a single buffer, so pending elements can keep referencing it rather than copying their attributes.
+    /// If resolveElements is set, the geometry of each element is resolved on its own as it is built.
+    SvgShapeReader(bool stableText, double arcTolerance, bool resolveElements, bool spriteSheet = false) : stableText(stableText), spriteSheet(spriteSheet), resolveElements(resolveElements), arcTolerance(arcTolerance), endpointSnapRange(0), documentArcTolerance(0), pass(0), rootStarted(false), failed(false), pendingTextSize(0) {
+        document.scale = 1;
+        document.captured = true;
+    }
+
+    bool startElement(const XmlElement &element) {
+        if (open.empty()) {
+            if (rootStarted || !(element.name == "svg"))
+                return false;
+            rootStarted = true;
+            SvgOpenElement root = { SvgTransform(), NULL, true, true, false };
+            if (!pass) {
+                dims = readSvgViewport(root.transform, element);
+                endpointSnapRange = ENDPOINT_SNAP_RANGE_PROPORTION*dims.length();
+                // The scales of sprites are relative to a unit size rather than the document
+                if (spriteSheet)
+                    documentArcTolerance = arcTolerance;
+                else {
+                    documentArcTolerance = arcTolerance*min(dims.x, dims.y);
+                    root.target = &document;
+                }
+            }
+            open.push_back(root);
+            return true;
+        }
+        const SvgOpenElement &parent = open.back();
+        SvgOpenElement current = parent;
+        bool visited = parent.childrenVisited, captureRoot = false;
+        if (pass) {
+            if (const TextRange *id = element.attribute("id")) {
+                std::unordered_map<std::string, SvgTemplate>::iterator referenced = templates.find(std::string(id->begin, id->end));
+                if (referenced != templates.end() && !referenced->second.captured && !referenced->second.missing) {
+                    // A referenced element inside another one is instanced through the enclosing template
+                    if (current.target && visited) {
+                        addPiece(*current.target, -1, referenced->first, current.transform);
+                        referenced->second.scale = max(referenced->second.scale, current.target->scale*current.transform.maxScale());
+                    }
+                    referenced->second.captured = true;
+                    current.target = &referenced->second;
+                    current.transform = SvgTransform();
+                    current.hidden = false;
+                    visited = captureRoot = true;
+                }
+            }
+        } else if (spriteSheet && (element.name == "symbol" || (element.name == "g" && parent.spriteContainer))) {
+            if (const TextRange *id = element.attribute("id")) {
+                if (SvgTemplate *sprite = addSprite(std::string(id->begin, id->end), element)) {
+                    current.target = sprite;
+                    current.transform = SvgTransform();
+                    current.hidden = false;
+                    visited = captureRoot = true;
+                }
+            }
+        }
+        current.spriteContainer = open.size() == 1 && element.name == "defs";
+        current.hidden = current.hidden || isHidden(element);
+        if (current.target && visited && current.hidden) {
+            if (isSvgShape(element))
+                ++stats.hiddenElements;
+        } else if (current.target && visited) {
+            current.transform = current.transform*readElementTransform(element);
+            if (isSvgShape(element)) {
+                if (!addShape(*current.target, element, current.transform))
+                    return false;
+            } else if (element.name == "use")
+                addReference(*current.target, element, current.transform);
+        }
+        // The children of a referenced <symbol> are rendered through the reference
+        current.childrenVisited = visited && (captureRoot || isRenderedContainer(element));
+        open.push_back(current);
+        return true;
+    }
+
+    bool endElement() {
+        open.pop_back();
+        return true;
+    }
+
+    /// Builds all queued shape elements. Returns false if any of them is malformed.
+    bool flush() {
+        std::vector<char> results(pendingShapes.size(), true);
+        ParallelFor((int32) pendingShapes.size(), [&](int32 i) {
+            const SvgPendingShape &pending = pendingShapes[i];
+            XmlElement element = { pending.name, pendingAttributes.data()+pending.firstAttribute, pending.attributeCount };
+            Shape &shape = shapes[pending.shape];
+            results[i] = buildShapeFromSvgElement(shape, pending.transform, element, endpointSnapRange, pending.arcTolerance);
+            // Contours left without edges, e.g. by a lone moveto, are dropped here, and elements without any are counted as empty
+            std::vector<Contour>::iterator kept = shape.contours.begin();
+            for (std::vector<Contour>::iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour) {
+                if (contour->edges.empty())
+                    continue;
+                if (kept != contour)
+                    *kept = (Contour &&) *contour;
+                ++kept;
+            }
+            shape.contours.erase(kept, shape.contours.end());
+            // Elements are placed together under the non-zero rule, so each one's fill is made positive on its own first -
+            // otherwise an element wound the other way would cancel out the fill of any element it overlaps
+            if (!resolveElements || shape.edgeCount() > SVG_RESOLVE_ELEMENT_EDGES || !resolveShapeGeometry(shape)) {
+                double area = 0;
+                for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour)
+                    area += contour->area();
+                if (area < 0) {
+                    for (std::vector<Contour>::iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour)
+                        contour->reverse();
+                }
+            }
+        }, EParallelForFlags::Unbalanced);
+        for (std::vector<SvgPendingShape>::const_iterator pending = pendingShapes.begin(); pending != pendingShapes.end(); ++pending)
+            stats.emptyElements += shapes[pending->shape].contours.empty();
+        pendingShapes.clear();
+        pendingAttributes.clear();
+        pendingText.clear();
+        pendingTextSize = 0;
+        for (std::vector<char>::const_iterator result = results.begin(); result != results.end(); ++result)
+            failed |= !*result;
+        return !failed;
+    }
 
-    return loadSvgFromXml(output, doc, pathIndex, dimensions);
+    /// Prepares another pass over the document to capture the elements referenced by the previous ones.
+    /// Returns false if there are none left to look for.
+    bool beginCapturePass() {
+        bool capturesLeft = false;
+        for (std::unordered_map<std::string, SvgTemplate>::iterator referenced = templates.begin(); referenced != templates.end(); ++referenced) {
+            SvgTemplate &reference = referenced->second;
+            if (reference.captured || reference.missing)
+                continue;
+            // An element referenced before the last pass started would have been captured by it
+            if (reference.requestPass < pass)
+                reference.missing = true;
+            else
+                capturesLeft = true;
+        }
+        if (!capturesLeft || pass >= MAX_USE_DEPTH)
+            return false;
+        ++pass;
+        rootStarted = false;
+        open.clear();
+        return true;
+    }
+
+    Vector2 dimensions() const {
+        return dims;
+    }
+
+    const SvgImportStats & importStats() const {
+        return stats;
+    }
+
+    /// Places the built shapes and the instances of templates into output in document order.
+    /// If pathIndex is not 0, only the single placed shape it selects is kept.
+    /// Returns false if the instances would have more than MAX_PLACED_EDGES edges.
+    bool assemble(Shape &output, int pathIndex) {
+        std::vector<SvgInstance> instances;
+        size_t edgesLeft = MAX_PLACED_EDGES;
+        if (!addInstances(instances, document, SvgTransform(), 0, edgesLeft)) {
+            stats.placedEdgeLimitExceeded = true;
+            return false;
+        }
+        if (pathIndex > 0 || pathIndex < 0) {
+            int index = pathIndex > 0 ? pathIndex-1 : (int) instances.size()+pathIndex;
+            if (index < 0 || index >= (int) instances.size())
+                return false;
+            SvgInstance instance = instances[index];
+            instances.assign(1, instance);
+        }
+        std::vector<int> shapeInstances(shapes.size(), 0);
+        countInstances(shapeInstances, instances);
+        return placeInstances(output, instances, shapeInstances);
+    }
+
+    /// Places the instances of each sprite into a shape of its own, in document order. Sprites without any geometry are left out.
+    /// A sprite without a viewBox is moved to the origin, and its dimensions are those of its bounds.
+    /// Returns false if the sprites together would have more than MAX_PLACED_EDGES edges.
+    bool assembleSprites(std::vector<SvgSprite> &output) {
+        std::vector<std::vector<SvgInstance> > instances(sprites.size());
+        std::vector<int> shapeInstances(shapes.size(), 0);
+        size_t edgesLeft = MAX_PLACED_EDGES;
+        output.clear();
+        for (int i = 0; i < (int) sprites.size(); ++i) {
+            if (!addInstances(instances[i], *sprites[i].source, sprites[i].placement, 0, edgesLeft)) {
+                stats.placedEdgeLimitExceeded = true;
+                return false;
+            }
+            countInstances(shapeInstances, instances[i]);
+        }
+        output.reserve(sprites.size());
+        for (int i = 0; i < (int) sprites.size(); ++i) {
+            SvgSprite sprite;
+            if (!placeInstances(sprite.shape, instances[i], shapeInstances))
+                continue;
+            sprite.id = sprites[i].id;
+            sprite.dimensions = sprites[i].dimensions;
+            sprite.viewBox = sprites[i].viewBox;
+            if (!sprite.viewBox) {
+                Shape::Bounds bounds = sprite.shape.getBounds();
+                SvgTransform offset(1, 0, 0, 1, -bounds.l, -bounds.b);
+                for (std::vector<Contour>::iterator contour = sprite.shape.contours.begin(); contour != sprite.shape.contours.end(); ++contour) {
+                    for (std::vector<EdgeHolder>::iterator edge = contour->edges.begin(); edge != contour->edges.end(); ++edge)
+                        *edge = transformEdge(*edge, offset);
+                }
+                sprite.dimensions.set(bounds.r-bounds.l, bounds.t-bounds.b);
+            }
+            output.push_back((SvgSprite &&) sprite);
+        }
+        return true;
+    }
+
+private:
+    bool stableText, spriteSheet, resolveElements;
+    double arcTolerance;
+    Vector2 dims;
+    double endpointSnapRange, documentArcTolerance;
+    /// 0 for the pass reading the document, then the number of the capture pass
+    int pass;
+    bool rootStarted, failed;
+    std::vector<SvgOpenElement> open;
+    SvgTemplate document;
+    std::unordered_map<std::string, SvgTemplate> templates;
+    std::vector<SvgSpriteSource> sprites;
+    std::vector<Shape> shapes;
+    SvgImportStats stats;
+
+    std::vector<SvgPendingShape> pendingShapes;
+    std::vector<XmlAttribute> pendingAttributes;
+    /// Copies of the text of pending elements, in blocks that never reallocate
+    std::vector<std::vector<char> > pendingText;
+    size_t pendingTextSize;
+
+    void countInstances(std::vector<int> &shapeInstances, const std::vector<SvgInstance> &instances) const {
+        for (std::vector<SvgInstance>::const_iterator instance = instances.begin(); instance != instances.end(); ++instance)
+            ++shapeInstances[instance->shape];
+    }
+
+    /// Places instances into output. shapeInstances holds the number of instances of each shape yet to be placed, including these.
+    bool placeInstances(Shape &output, const std::vector<SvgInstance> &instances, std::vector<int> &shapeInstances) {
+        size_t contourCount = 0;
+        for (std::vector<SvgInstance>::const_iterator instance = instances.begin(); instance != instances.end(); ++instance)
+            contourCount += shapes[instance->shape].contours.size();
+        output.contours.clear();
+        output.inverseYAxis = true;
+        if (!contourCount)
+            return false;
+        output.contours.reserve(contourCount);
+        for (std::vector<SvgInstance>::const_iterator instance = instances.begin(); instance != instances.end(); ++instance) {
+            std::vector<Contour> &contours = shapes[instance->shape].contours;
+            bool identity = instance->transform.isIdentity();
+            // A mirrored instance is reversed to keep the positive fill its shape was built with
+            bool mirror = instance->transform.isMirror();
+            // The last instance of a shape takes its contours rather than copying them
+            if (!--shapeInstances[instance->shape]) {
+                for (std::vector<Contour>::iterator contour = contours.begin(); contour != contours.end(); ++contour) {
+                    output.contours.push_back((Contour &&) *contour);
+                    if (!identity) {
+                        for (std::vector<EdgeHolder>::iterator edge = output.contours.back().edges.begin(); edge != output.contours.back().edges.end(); ++edge)
+                            *edge = transformEdge(*edge, instance->transform);
+                    }
+                    if (mirror)
+                        output.contours.back().reverse();
+                }
+                continue;
+            }
+            for (std::vector<Contour>::const_iterator contour = contours.begin(); contour != contours.end(); ++contour) {
+                Contour &instanceContour = output.addContour();
+                instanceContour.edges.reserve(contour->edges.size());
+                for (std::vector<EdgeHolder>::const_iterator edge = contour->edges.begin(); edge != contour->edges.end(); ++edge)
+                    instanceContour.edges.push_back(transformEdge(*edge, instance->transform));
+                if (mirror)
+                    instanceContour.reverse();
+            }
+        }
+        return true;
+    }
+
+    void addPiece(SvgTemplate &target, int shape, const std::string &reference, const SvgTransform &transform) {
+        SvgPiece piece;
+        piece.shape = shape;
+        piece.reference = reference;
+        piece.transform = transform;
+        target.pieces.push_back((SvgPiece &&) piece);
+    }
+
+    /// Copies text that must outlive the current piece of markup, followed by a null character.
+    TextRange keepText(TextRange text) {
+        size_t length = text.end-text.begin;
+        if (pendingText.empty() || pendingText.back().capacity()-pendingText.back().size() < length+1) {
+            pendingText.push_back(std::vector<char>());
+            pendingText.back().reserve(max(length+1, (size_t) SVG_PENDING_TEXT_BLOCK_SIZE));
+        }
+        std::vector<char> &block = pendingText.back();
+        const char *begin = block.data()+block.size();
+        block.insert(block.end(), text.begin, text.end);
+        block.push_back('\0');
+        pendingTextSize += length+1;
+        TextRange copy = { begin, begin+length };
+        return copy;
+    }
+
+    /// Queues a shape element to be built, which is mapped by transform as it is parsed.
+    bool addShape(SvgTemplate &target, const XmlElement &element, const SvgTransform &transform) {
+        SvgPendingShape pending;
+        pending.name = stableText ? element.name : keepText(element.name);
+        pending.firstAttribute = (int) pendingAttributes.size();
+        pending.attributeCount = element.attributeCount;
+        for (int i = 0; i < element.attributeCount; ++i) {
+            XmlAttribute attribute = element.attributes[i];
+            if (!stableText) {
+                attribute.name = keepText(attribute.name);
+                attribute.value = keepText(attribute.value);
+            }
+            pendingAttributes.push_back(attribute);
+        }
+        pending.transform = transform;
+        // A template's arcs are approximated finely enough for its most enlarged instance
+        pending.arcTolerance = target.scale > 0 ? documentArcTolerance/target.scale : documentArcTolerance;
+        pending.shape = (int) shapes.size();
+        shapes.push_back(Shape());
+        pendingShapes.push_back(pending);
+        addPiece(target, pending.shape, std::string(), SvgTransform());
+        if (pendingShapes.size() >= SVG_BATCH_SHAPES || pendingTextSize >= SVG_BATCH_TEXT_SIZE)
+            return flush();
+        return true;
+    }
+
+    /// Captures a sprite as the template with its id, which it shares with any <use> references to it.
+    /// Returns NULL if an element with the same id has been captured already.
+    SvgTemplate * addSprite(const std::string &id, const XmlElement &element) {
+        std::pair<std::unordered_map<std::string, SvgTemplate>::iterator, bool> captured = templates.emplace(id, SvgTemplate());
+        SvgTemplate &sprite = captured.first->second;
+        if (sprite.captured)
+            return NULL;
+        sprite.captured = true;
+        SvgSpriteSource source;
+        source.id = id;
+        source.source = &sprite;
+        Point2 origin;
+        source.viewBox = element.name == "symbol" && readViewBox(origin, source.dimensions, element);
+        if (source.viewBox) {
+            source.placement = SvgTransform(1, 0, 0, 1, -origin.x, -origin.y);
+            sprite.scale = max(sprite.scale, 1/min(source.dimensions.x, source.dimensions.y));
+        } else {
+            // A group's size is not known until it is built, so its arcs keep the default error relative to their radii
+            sprite.scale = std::numeric_limits<double>::infinity();
+        }
+        sprites.push_back((SvgSpriteSource &&) source);
+        return &sprite;
+    }
+
+    /// Notes a <use> reference to be instanced, offset by its x and y attributes.
+    void addReference(SvgTemplate &target, const XmlElement &element, const SvgTransform &transform) {
+        const TextRange *href = element.attribute("href");
+        if (!href)
+            href = element.attribute("xlink:href");
+        if (!href || href->begin == href->end || *href->begin != '#')
+            return;
+        std::string id(href->begin+1, href->end);
+        SvgTransform referenceTransform = transform*SvgTransform(1, 0, 0, 1, readLength(element, "x"), readLength(element, "y"));
+        std::pair<std::unordered_map<std::string, SvgTemplate>::iterator, bool> referenced = templates.emplace(id, SvgTemplate());
+        if (referenced.second)
+            referenced.first->second.requestPass = pass;
+        referenced.first->second.scale = max(referenced.first->second.scale, target.scale*referenceTransform.maxScale());
+        addPiece(target, -1, id, referenceTransform);
+    }
+
+    /// Adds the instances of the shapes of source. Returns false once they would take more edges than edgesLeft.
+    bool addInstances(std::vector<SvgInstance> &instances, const SvgTemplate &source, const SvgTransform &transform, int useDepth, size_t &edgesLeft) const {
+        for (std::vector<SvgPiece>::const_iterator piece = source.pieces.begin(); piece != source.pieces.end(); ++piece) {
+            if (piece->shape >= 0) {
+                size_t edgeCount = max((size_t) shapes[piece->shape].edgeCount(), (size_t) 1);
+                if (edgeCount > edgesLeft)
+                    return false;
+                edgesLeft -= edgeCount;
+                SvgInstance instance = { piece->shape, transform*piece->transform };
+                instances.push_back(instance);
+            } else if (useDepth < MAX_USE_DEPTH) {
+                std::unordered_map<std::string, SvgTemplate>::const_iterator referenced = templates.find(piece->reference);
+                if (referenced != templates.end() && referenced->second.captured && !addInstances(instances, referenced->second, transform*piece->transform, useDepth+1, edgesLeft))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+};
+
+static bool loadSvgSprites(std::vector<SvgSprite> &output, const char *file, size_t fileLength, const char *filename, double arcTolerance, SvgImportStats *stats, bool resolveElements) {
+    SvgShapeReader reader(!filename, arcTolerance, resolveElements, true);
+    do {
+        if (!(filename ? readXmlFile(reader, filename) : readXml(reader, file, fileLength)) || !reader.flush())
+            return false;
+    } while (reader.beginCapturePass());
+    bool assembled = reader.assembleSprites(output);
+    if (stats)
+        *stats = reader.importStats();
+    return assembled && !output.empty();
+}
+
+bool buildShapesFromSvgSpriteSheet(std::vector<SvgSprite> &output, const char *file, size_t fileLength, double arcTolerance, SvgImportStats *stats, bool resolveElements) {
+    return loadSvgSprites(output, file, fileLength, NULL, arcTolerance, stats, resolveElements);
+}
+
+bool loadSvgSpriteSheet(std::vector<SvgSprite> &output, const char *filename, double arcTolerance, SvgImportStats *stats, bool resolveElements) {
+    return loadSvgSprites(output, NULL, 0, filename, arcTolerance, stats, resolveElements);
 }
+
+static bool loadSvg(Shape &output, const char *file, size_t fileLength, const char *filename, int pathIndex, Vector2 *dimensions, double arcTolerance, SvgImportStats *stats, bool resolveElements) {
+    SvgShapeReader reader(!filename, arcTolerance, resolveElements);
+    do {
+        if (!(filename ? readXmlFile(reader, filename) : readXml(reader, file, fileLength)) || !reader.flush())
+            return false;
+    } while (reader.beginCapturePass());
+    if (dimensions)
+        *dimensions = reader.dimensions();
+    bool assembled = reader.assemble(output, pathIndex);
+    if (stats)
+        *stats = reader.importStats();
+    return assembled;
+}
+
+bool loadSvgShape(Shape &output, const char *filename, int pathIndex, Vector2 *dimensions, double arcTolerance, SvgImportStats *stats, bool resolveElements) {
+    return loadSvg(output, NULL, 0, filename, pathIndex, dimensions, arcTolerance, stats, resolveElements);
+}
+
+bool buildShapeFromSvgFileBuffer(Shape &output, const char* file, size_t fileLength, int pathIndex, Vector2 *dimensions, double arcTolerance, SvgImportStats *stats, bool resolveElements){
+    return loadSvg(output, file, fileLength, NULL, pathIndex, dimensions, arcTolerance, stats, resolveElements);
+}
+
 }
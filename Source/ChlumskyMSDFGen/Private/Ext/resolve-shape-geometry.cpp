@@ -75,4 +75,567 @@ bool resolveShapeGeometry(Shape &shape) {
 
 }
 
+#else
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <vector>
+#include "../core/arithmetics.hpp"
+#include "../core/edge-segments.h"
+#include "../core/Contour.h"
+#include "Async/ParallelFor.h"
+
+// Intersections are located to within this portion of the shape's size.
+#define MSDFGEN_RESOLVE_TOLERANCE 1e-9
+// Points closer than this portion of the shape's size are merged into a single vertex.
+#define MSDFGEN_RESOLVE_VERTEX_DISTANCE 1e-7
+// Fill is sampled this portion of the shape's size either side of each edge piece.
+#define MSDFGEN_RESOLVE_SIDE_OFFSET 1e-6
+// Bounding box tests allowed per pair of edges. Only coincident curves need more, and those are not resolved.
+#define MSDFGEN_RESOLVE_MAX_STEPS_PER_PAIR 4096
+// Average number of edges per bucket of the vertical index used to sample the fill.
+#define MSDFGEN_RESOLVE_EDGES_PER_BUCKET 4
+// Edges spanning more buckets than this are moved to a level of coarser buckets.
+#define MSDFGEN_RESOLVE_MAX_BUCKET_SPAN 16
+// Average number of edges per cell of the grid used to find candidate pairs of intersecting edges.
+#define MSDFGEN_RESOLVE_EDGES_PER_CELL 4
+// Upper limit on the number of cells along each side of that grid.
+#define MSDFGEN_RESOLVE_MAX_GRID_SIZE 256
+// Fewer candidate pairs than this are intersected on the calling thread.
+#define MSDFGEN_RESOLVE_MIN_PARALLEL_PAIRS 256
+
+namespace msdfgen {
+
+/// Edge geometry as plain control points - 2 for lines, 3 for quadratic and 4 for cubic curves.
+struct ControlPoints {
+    Point2 p[4];
+    int n;
+    double l, b, r, t;
+
+    void updateBounds() {
+        l = r = p[0].x, b = t = p[0].y;
+        for (int i = 1; i < n; ++i) {
+            l = std::min(l, p[i].x), r = std::max(r, p[i].x);
+            b = std::min(b, p[i].y), t = std::max(t, p[i].y);
+        }
+    }
+};
+
+struct EdgeSplit {
+    double param;
+    Point2 point;
+
+    bool operator<(const EdgeSplit &other) const {
+        return param < other.param;
+    }
+};
+
+struct EdgeHit {
+    double paramA, paramB;
+
+    bool operator<(const EdgeHit &other) const {
+        return paramA < other.paramA;
+    }
+};
+
+static ControlPoints controlPoints(const EdgeSegment *edge) {
+    ControlPoints cp = { };
+    switch (edge->type) {
+        case EdgeSegment::SegmentType::Linear:
+            cp.n = 2;
+            std::copy(static_cast<const LinearSegment *>(edge)->p, static_cast<const LinearSegment *>(edge)->p+2, cp.p);
+            break;
+        case EdgeSegment::SegmentType::Quadratic:
+            cp.n = 3;
+            std::copy(static_cast<const QuadraticSegment *>(edge)->p, static_cast<const QuadraticSegment *>(edge)->p+3, cp.p);
+            break;
+        case EdgeSegment::SegmentType::Cubic:
+            cp.n = 4;
+            std::copy(static_cast<const CubicSegment *>(edge)->p, static_cast<const CubicSegment *>(edge)->p+4, cp.p);
+            break;
+        default:;
+    }
+    cp.updateBounds();
+    return cp;
+}
+
+static EdgeHolder edgeFromControlPoints(const ControlPoints &cp) {
+    switch (cp.n) {
+        case 2:
+            return EdgeHolder(cp.p[0], cp.p[1]);
+        case 3:
+            return EdgeHolder(cp.p[0], cp.p[1], cp.p[2]);
+        default:
+            return EdgeHolder(cp.p[0], cp.p[1], cp.p[2], cp.p[3]);
+    }
+}
+
+/// Splits a curve in two at param (de Casteljau).
+static void splitControlPoints(const ControlPoints &cp, double param, ControlPoints &left, ControlPoints &right) {
+    Point2 q[4];
+    std::copy(cp.p, cp.p+cp.n, q);
+    left.n = right.n = cp.n;
+    left.p[0] = q[0];
+    right.p[cp.n-1] = q[cp.n-1];
+    for (int level = 1; level < cp.n; ++level) {
+        for (int i = 0; i < cp.n-level; ++i)
+            q[i] = mix(q[i], q[i+1], param);
+        left.p[level] = q[0];
+        right.p[cp.n-1-level] = q[cp.n-1-level];
+    }
+    left.updateBounds();
+    right.updateBounds();
+}
+
+static ControlPoints subCurve(const ControlPoints &cp, double param0, double param1) {
+    ControlPoints head, tail, middle;
+    if (param1 < 1)
+        splitControlPoints(cp, param1, head, tail);
+    else
+        head = cp;
+    if (param0 > 0)
+        splitControlPoints(head, param0/param1, tail, middle);
+    else
+        middle = head;
+    return middle;
+}
+
+static bool boundsOverlap(const ControlPoints &a, const ControlPoints &b, double tolerance) {
+    return a.l <= b.r+tolerance && b.l <= a.r+tolerance && a.b <= b.t+tolerance && b.b <= a.t+tolerance;
+}
+
+static bool isFlat(const ControlPoints &cp, double tolerance) {
+    Vector2 chord = cp.p[cp.n-1]-cp.p[0];
+    double chordLength = chord.length();
+    for (int i = 1; i < cp.n-1; ++i) {
+        double distance = chordLength > 0 ? fabs(crossProduct(chord, cp.p[i]-cp.p[0]))/chordLength : (cp.p[i]-cp.p[0]).length();
+        if (distance > tolerance)
+            return false;
+    }
+    return true;
+}
+
+/// Half-angle of the cone from vertex containing the curve's control points, around its chord, or -1 if it is not narrower than a half-plane.
+static double coneAngle(const ControlPoints &cp, Point2 vertex, Vector2 &axis) {
+    axis = (cp.p[0] == vertex ? cp.p[cp.n-1] : cp.p[0])-vertex;
+    if (!axis)
+        return -1;
+    axis = axis.normalize();
+    double minCos = 1;
+    for (int i = 0; i < cp.n; ++i) {
+        Vector2 v = cp.p[i]-vertex;
+        if (!!v)
+            minCos = std::min(minCos, dotProduct(v.normalize(), axis));
+    }
+    return minCos > 0 ? acos(minCos) : -1;
+}
+
+/// Checks whether two curves sharing an end point provably meet nowhere else, which is the case when the cones from that point containing their control points are disjoint.
+static bool separatedAtSharedEnd(const ControlPoints &a, const ControlPoints &b) {
+    Point2 vertex;
+    if (a.p[0] == b.p[0] || a.p[0] == b.p[b.n-1])
+        vertex = a.p[0];
+    else if (a.p[a.n-1] == b.p[0] || a.p[a.n-1] == b.p[b.n-1])
+        vertex = a.p[a.n-1];
+    else
+        return false;
+    Vector2 aAxis, bAxis;
+    double aAngle = coneAngle(a, vertex, aAxis), bAngle = coneAngle(b, vertex, bAxis);
+    if (aAngle < 0 || bAngle < 0)
+        return false;
+    return acos(clamp(dotProduct(aAxis, bAxis), -1., 1.)) > aAngle+bAngle;
+}
+
+static void addHit(std::vector<EdgeHit> &hits, double a0, double a1, double aParam, double b0, double b1, double bParam) {
+    EdgeHit hit = { mix(a0, a1, clamp(aParam, 1.)), mix(b0, b1, clamp(bParam, 1.)) };
+    hits.push_back(hit);
+}
+
+/// Intersects the chords of two flat curves, including the ends of collinear chords lying on each other.
+static void intersectChords(const ControlPoints &a, double a0, double a1, const ControlPoints &b, double b0, double b1, double tolerance, std::vector<EdgeHit> &hits) {
+    Point2 p = a.p[0], q = b.p[0];
+    Vector2 da = a.p[a.n-1]-p, db = b.p[b.n-1]-q;
+    double aLength = da.length(), bLength = db.length();
+    if (aLength <= tolerance || bLength <= tolerance)
+        return;
+    double denominator = crossProduct(da, db);
+    if (fabs(denominator) > tolerance*std::max(aLength, bLength)) {
+        double aParam = crossProduct(q-p, db)/denominator;
+        double bParam = crossProduct(q-p, da)/denominator;
+        double aSlack = tolerance/aLength, bSlack = tolerance/bLength;
+        if (aParam >= -aSlack && aParam <= 1+aSlack && bParam >= -bSlack && bParam <= 1+bSlack)
+            addHit(hits, a0, a1, aParam, b0, b1, bParam);
+    } else if (fabs(crossProduct(da, q-p))/aLength <= tolerance) {
+        // Collinear - each end lying within the other chord splits it
+        double aParams[2] = { dotProduct(q-p, da)/(aLength*aLength), dotProduct(b.p[b.n-1]-p, da)/(aLength*aLength) };
+        double bParams[2] = { dotProduct(p-q, db)/(bLength*bLength), dotProduct(a.p[a.n-1]-q, db)/(bLength*bLength) };
+        for (int i = 0; i < 2; ++i) {
+            if (aParams[i] > 0 && aParams[i] < 1)
+                addHit(hits, a0, a1, aParams[i], b0, b1, i);
+            if (bParams[i] > 0 && bParams[i] < 1)
+                addHit(hits, a0, a1, i, b0, b1, bParams[i]);
+        }
+    }
+}
+
+/// Finds intersections between two curves by subdividing them until both are flat within tolerance and intersecting their chords.
+/// Returns false if the step budget runs out, which happens when curves coincide over some length.
+static bool findEdgeHits(const ControlPoints &a, double a0, double a1, const ControlPoints &b, double b0, double b1, double tolerance, std::vector<EdgeHit> &hits, int &steps) {
+    if (++steps > MSDFGEN_RESOLVE_MAX_STEPS_PER_PAIR)
+        return false;
+    if (!boundsOverlap(a, b, tolerance))
+        return true;
+    // Neighboring edges would otherwise be subdivided down to the tolerance around the point they share
+    if (separatedAtSharedEnd(a, b))
+        return true;
+    bool aFlat = isFlat(a, tolerance), bFlat = isFlat(b, tolerance);
+    if (aFlat && bFlat) {
+        intersectChords(a, a0, a1, b, b0, b1, tolerance, hits);
+        return true;
+    }
+    // The larger curve is split even if flat so that the bounds of both keep shrinking
+    ControlPoints left, right;
+    if (std::max(a.r-a.l, a.t-a.b) >= std::max(b.r-b.l, b.t-b.b)) {
+        double am = .5*(a0+a1);
+        splitControlPoints(a, .5, left, right);
+        return findEdgeHits(left, a0, am, b, b0, b1, tolerance, hits, steps) && findEdgeHits(right, am, a1, b, b0, b1, tolerance, hits, steps);
+    } else {
+        double bm = .5*(b0+b1);
+        splitControlPoints(b, .5, left, right);
+        return findEdgeHits(a, a0, a1, left, b0, bm, tolerance, hits, steps) && findEdgeHits(a, a0, a1, right, bm, b1, tolerance, hits, steps);
+    }
+}
+
+/// Polishes a crossing found on the chords with Newton's method, as a chord's parametrization differs from its curve's.
+static void refineHit(const EdgeSegment *a, const EdgeSegment *b, EdgeHit &hit) {
+    double residual = (a->point(hit.paramA)-b->point(hit.paramB)).length();
+    for (int i = 0; i < 8 && residual > 0; ++i) {
+        Vector2 rhs = b->point(hit.paramB)-a->point(hit.paramA);
+        Vector2 da = a->direction(hit.paramA), db = b->direction(hit.paramB);
+        double determinant = -crossProduct(da, db);
+        if (determinant == 0)
+            return;
+        double paramA = hit.paramA+crossProduct(rhs, -db)/determinant;
+        double paramB = hit.paramB+crossProduct(da, rhs)/determinant;
+        if (paramA < 0 || paramA > 1 || paramB < 0 || paramB > 1)
+            return;
+        double newResidual = (a->point(paramA)-b->point(paramB)).length();
+        if (!(newResidual < residual))
+            return;
+        hit.paramA = paramA, hit.paramB = paramB;
+        residual = newResidual;
+    }
+}
+
+/// Computes the non-zero winding of the original shape at arbitrary points, visiting only edges that span the point's Y.
+/// Edges are kept in levels of vertical buckets, each level's buckets being MSDFGEN_RESOLVE_MAX_BUCKET_SPAN times taller than the previous.
+class WindingSampler {
+
+public:
+    WindingSampler(const std::vector<const EdgeSegment *> &edges, const std::vector<ControlPoints> &bounds, const std::vector<int> &edgeContours, const std::vector<ControlPoints> &contourBounds, double bottom, double top) : edges(edges), bounds(bounds), edgeContours(edgeContours), contourBounds(contourBounds), bottom(bottom) {
+        int bucketCount = std::max(1, (int) edges.size()/MSDFGEN_RESOLVE_EDGES_PER_BUCKET);
+        scale = top > bottom ? bucketCount/(top-bottom) : 0;
+        for (int count = bucketCount; ; count = (count+MSDFGEN_RESOLVE_MAX_BUCKET_SPAN-1)/MSDFGEN_RESOLVE_MAX_BUCKET_SPAN) {
+            levels.push_back(std::vector<std::vector<int> >(count));
+            if (count == 1)
+                break;
+        }
+        for (int i = 0; i < (int) edges.size(); ++i) {
+            int level = 0, bucketBottom = bucketIndex(bounds[i].b, 0), bucketTop = bucketIndex(bounds[i].t, 0);
+            while (bucketTop-bucketBottom >= MSDFGEN_RESOLVE_MAX_BUCKET_SPAN && level+1 < (int) levels.size()) {
+                ++level;
+                bucketBottom = bucketIndex(bounds[i].b, level), bucketTop = bucketIndex(bounds[i].t, level);
+            }
+            for (int j = bucketBottom; j <= bucketTop; ++j)
+                levels[level][j].push_back(i);
+        }
+    }
+
+    int winding(Point2 point) const {
+        int total = 0;
+        double x[3];
+        int dy[3];
+        for (int level = 0; level < (int) levels.size(); ++level) {
+            const std::vector<int> &candidates = levels[level][bucketIndex(point.y, level)];
+            for (std::vector<int>::const_iterator i = candidates.begin(); i != candidates.end(); ++i) {
+                // A closed contour does not wind around points outside its bounds, so its edges can be skipped together
+                const ControlPoints &contour = contourBounds[edgeContours[*i]];
+                if (point.x < contour.l || point.x > contour.r || point.y < contour.b || point.y > contour.t) {
+                    for (int c = edgeContours[*i]; i+1 != candidates.end() && edgeContours[*(i+1)] == c; ++i);
+                    continue;
+                }
+                if (point.y < bounds[*i].b || point.y > bounds[*i].t)
+                    continue;
+                int n = edges[*i]->scanlineIntersections(x, dy, point.y);
+                for (int k = 0; k < n; ++k)
+                    if (x[k] < point.x)
+                        total += dy[k];
+            }
+        }
+        return total;
+    }
+
+private:
+    const std::vector<const EdgeSegment *> &edges;
+    const std::vector<ControlPoints> &bounds;
+    const std::vector<int> &edgeContours;
+    const std::vector<ControlPoints> &contourBounds;
+    double bottom, scale;
+    std::vector<std::vector<std::vector<int> > > levels;
+
+    int bucketIndex(double y, int level) const {
+        int index = (int) std::min(std::max(scale*(y-bottom), 0.), (double) levels[0].size()-1);
+        for (int i = 0; i < level; ++i)
+            index /= MSDFGEN_RESOLVE_MAX_BUCKET_SPAN;
+        return index;
+    }
+
+};
+
+/// Merges points within a given distance of each other into shared vertices.
+class VertexIndex {
+
+public:
+    explicit VertexIndex(double distance) : distance(distance) { }
+
+    int find(Point2 point) {
+        long long cellX = (long long) floor(point.x/distance), cellY = (long long) floor(point.y/distance);
+        for (long long y = cellY-1; y <= cellY+1; ++y)
+            for (long long x = cellX-1; x <= cellX+1; ++x) {
+                std::map<std::pair<long long, long long>, std::vector<int> >::const_iterator cell = cells.find(std::make_pair(x, y));
+                if (cell != cells.end())
+                    for (std::vector<int>::const_iterator vertex = cell->second.begin(); vertex != cell->second.end(); ++vertex)
+                        if ((positions[*vertex]-point).length() <= distance)
+                            return *vertex;
+            }
+        cells[std::make_pair(cellX, cellY)].push_back((int) positions.size());
+        positions.push_back(point);
+        return (int) positions.size()-1;
+    }
+
+    Point2 position(int vertex) const {
+        return positions[vertex];
+    }
+
+private:
+    double distance;
+    std::vector<Point2> positions;
+    std::map<std::pair<long long, long long>, std::vector<int> > cells;
+
+};
+
+bool resolveShapeGeometry(Shape &shape) {
+    std::vector<const EdgeSegment *> edges;
+    std::vector<ControlPoints> edgePoints;
+    std::vector<int> edgeContours;
+    std::vector<ControlPoints> contourBounds;
+    for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour) {
+        if (contour->edges.empty())
+            continue;
+        ControlPoints bounds = controlPoints(contour->edges.front());
+        for (std::vector<EdgeHolder>::const_iterator edge = contour->edges.begin(); edge != contour->edges.end(); ++edge) {
+            edges.push_back(*edge);
+            edgePoints.push_back(controlPoints(*edge));
+            edgeContours.push_back((int) contourBounds.size());
+            const ControlPoints &cp = edgePoints.back();
+            bounds.l = std::min(bounds.l, cp.l), bounds.b = std::min(bounds.b, cp.b), bounds.r = std::max(bounds.r, cp.r), bounds.t = std::max(bounds.t, cp.t);
+        }
+        contourBounds.push_back(bounds);
+    }
+    if (edges.empty())
+        return true;
+
+    double l = edgePoints[0].l, b = edgePoints[0].b, r = edgePoints[0].r, t = edgePoints[0].t;
+    for (std::vector<ControlPoints>::const_iterator cp = contourBounds.begin(); cp != contourBounds.end(); ++cp)
+        l = std::min(l, cp->l), b = std::min(b, cp->b), r = std::max(r, cp->r), t = std::max(t, cp->t);
+    double size = std::max(std::max(r-l, t-b), 1e-240);
+    double tolerance = MSDFGEN_RESOLVE_TOLERANCE*size;
+    double vertexDistance = MSDFGEN_RESOLVE_VERTEX_DISTANCE*size;
+
+    // The fill rule is only defined for closed contours
+    for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour)
+        if (!contour->edges.empty() && (contour->edges.back()->point(1)-contour->edges.front()->point(0)).length() > vertexDistance)
+            return false;
+
+    // Bin the edge bounds into a uniform grid, so that only edges sharing a cell are tested against each other
+    int edgeCount = (int) edges.size();
+    int gridSize = std::max(std::min((int) sqrt((double) edgeCount/MSDFGEN_RESOLVE_EDGES_PER_CELL), MSDFGEN_RESOLVE_MAX_GRID_SIZE), 1);
+    double cellWidth = std::max(r-l, 1e-240)/gridSize, cellHeight = std::max(t-b, 1e-240)/gridSize;
+    std::vector<int> cellRanges(4*edgeCount);
+    std::vector<std::vector<int> > cells(gridSize*gridSize);
+    for (int i = 0; i < edgeCount; ++i) {
+        const ControlPoints &cp = edgePoints[i];
+        int *range = &cellRanges[4*i];
+        range[0] = std::max(std::min((int) ((cp.l-tolerance-l)/cellWidth), gridSize-1), 0);
+        range[1] = std::max(std::min((int) ((cp.b-tolerance-b)/cellHeight), gridSize-1), 0);
+        range[2] = std::max(std::min((int) ((cp.r+tolerance-l)/cellWidth), gridSize-1), 0);
+        range[3] = std::max(std::min((int) ((cp.t+tolerance-b)/cellHeight), gridSize-1), 0);
+        for (int y = range[1]; y <= range[3]; ++y)
+            for (int x = range[0]; x <= range[2]; ++x)
+                cells[gridSize*y+x].push_back(i);
+    }
+    std::vector<std::pair<int, int> > pairs;
+    for (int y = 0; y < gridSize; ++y) {
+        for (int x = 0; x < gridSize; ++x) {
+            const std::vector<int> &cell = cells[gridSize*y+x];
+            for (int i = 0; i < (int) cell.size(); ++i) {
+                const int *rangeA = &cellRanges[4*cell[i]];
+                for (int j = i+1; j < (int) cell.size(); ++j) {
+                    const int *rangeB = &cellRanges[4*cell[j]];
+                    // Each pair is only tested in the first cell both edges are binned into
+                    if (x == std::max(rangeA[0], rangeB[0]) && y == std::max(rangeA[1], rangeB[1]) && boundsOverlap(edgePoints[cell[i]], edgePoints[cell[j]], tolerance))
+                        pairs.push_back(std::make_pair(cell[i], cell[j]));
+                }
+            }
+        }
+    }
+
+    // Intersect the candidate pairs in parallel, then merge their hits in a fixed order
+    std::vector<std::vector<EdgeHit> > pairHits(pairs.size());
+    std::atomic<bool> unresolved(false);
+    ParallelFor((int32) pairs.size(), [&](int32 i) {
+        if (unresolved)
+            return;
+        std::vector<EdgeHit> &hits = pairHits[i];
+        int steps = 0;
+        if (!findEdgeHits(edgePoints[pairs[i].first], 0, 1, edgePoints[pairs[i].second], 0, 1, tolerance, hits, steps)) {
+            unresolved = true;
+            return;
+        }
+        std::sort(hits.begin(), hits.end());
+        for (std::vector<EdgeHit>::iterator hit = hits.begin(); hit != hits.end(); ++hit)
+            refineHit(edges[pairs[i].first], edges[pairs[i].second], *hit);
+    }, pairs.size() < MSDFGEN_RESOLVE_MIN_PARALLEL_PAIRS ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+    if (unresolved)
+        return false;
+    std::vector<std::vector<EdgeSplit> > splits(edgeCount);
+    for (int i = 0; i < (int) pairs.size(); ++i) {
+        const ControlPoints &a = edgePoints[pairs[i].first], &b = edgePoints[pairs[i].second];
+        const EdgeSegment *edgeA = edges[pairs[i].first], *edgeB = edges[pairs[i].second];
+        const std::vector<EdgeHit> &hits = pairHits[i];
+        Point2 previous;
+        for (int k = 0; k < (int) hits.size(); ++k) {
+            Point2 point = .5*(edgeA->point(hits[k].paramA)+edgeB->point(hits[k].paramB));
+            // Adjacent subdivisions report the same crossing
+            if (k > 0 && (point-previous).length() <= vertexDistance)
+                continue;
+            previous = point;
+            // Edges only touching at their ends need no splitting, and an end touching the other edge only splits the other edge
+            bool endOfA = (point-a.p[0]).length() <= vertexDistance || (point-a.p[a.n-1]).length() <= vertexDistance;
+            bool endOfB = (point-b.p[0]).length() <= vertexDistance || (point-b.p[b.n-1]).length() <= vertexDistance;
+            if (!endOfA) {
+                EdgeSplit split = { hits[k].paramA, point };
+                splits[pairs[i].first].push_back(split);
+            }
+            if (!endOfB) {
+                EdgeSplit split = { hits[k].paramB, point };
+                splits[pairs[i].second].push_back(split);
+            }
+        }
+    }
+
+    // Split edges into pieces that only meet at their ends
+    std::vector<ControlPoints> pieces;
+    std::vector<int> pieceContours;
+    bool split = false;
+    for (int i = 0; i < edgeCount; ++i) {
+        std::vector<EdgeSplit> &edgeSplits = splits[i];
+        std::sort(edgeSplits.begin(), edgeSplits.end());
+        const ControlPoints &cp = edgePoints[i];
+        double param = 0;
+        Point2 start = cp.p[0];
+        for (std::vector<EdgeSplit>::const_iterator s = edgeSplits.begin(); s != edgeSplits.end(); ++s) {
+            if ((s->point-start).length() <= vertexDistance)
+                continue;
+            ControlPoints piece = subCurve(cp, param, s->param);
+            piece.p[0] = start;
+            piece.p[piece.n-1] = s->point;
+            piece.updateBounds();
+            pieces.push_back(piece);
+            pieceContours.push_back(edgeContours[i]);
+            param = s->param;
+            start = s->point;
+            split = true;
+        }
+        ControlPoints piece = param > 0 ? subCurve(cp, param, 1) : cp;
+        piece.p[0] = start;
+        piece.updateBounds();
+        pieces.push_back(piece);
+        pieceContours.push_back(edgeContours[i]);
+    }
+
+    // Keep pieces separating filled from unfilled area, oriented to have the fill on their left
+    WindingSampler sampler(edges, edgePoints, edgeContours, contourBounds, b, t);
+    double sideOffset = MSDFGEN_RESOLVE_SIDE_OFFSET*size;
+    std::vector<ControlPoints> boundary;
+    boundary.reserve(pieces.size());
+    // Whether any contour has pieces reversed as well as pieces kept, as the lobes of a contour crossing itself at a vertex do
+    std::vector<char> contourReversal(contourBounds.size(), 0);
+    bool mixedReversal = false;
+    for (int i = 0; i < (int) pieces.size(); ++i) {
+        ControlPoints &piece = pieces[i];
+        EdgeHolder edge = edgeFromControlPoints(piece);
+        Point2 point = edge->point(.5);
+        Vector2 normal = edge->direction(.5).getOrthonormal(true, true);
+        bool leftFilled = sampler.winding(point+sideOffset*normal) != 0;
+        bool rightFilled = sampler.winding(point-sideOffset*normal) != 0;
+        if (leftFilled == rightFilled)
+            continue;
+        if (rightFilled)
+            std::reverse(piece.p, piece.p+piece.n);
+        char &reversal = contourReversal[pieceContours[i]];
+        char pieceReversal = rightFilled ? -1 : 1;
+        mixedReversal |= reversal && reversal != pieceReversal;
+        reversal = pieceReversal;
+        boundary.push_back(piece);
+    }
+    if (!split && !mixedReversal && boundary.size() == pieces.size()) {
+        // Nothing overlaps, so the contours can be kept as they are
+        shape.orientContours();
+        return true;
+    }
+
+    // Chain the boundary pieces into closed contours
+    VertexIndex vertices(vertexDistance);
+    std::vector<int> startVertices, endVertices;
+    std::vector<std::vector<int> > outgoing;
+    for (int i = 0; i < (int) boundary.size(); ++i) {
+        int startVertex = vertices.find(boundary[i].p[0]);
+        int endVertex = vertices.find(boundary[i].p[boundary[i].n-1]);
+        if (std::max(startVertex, endVertex) >= (int) outgoing.size())
+            outgoing.resize(std::max(startVertex, endVertex)+1);
+        startVertices.push_back(startVertex);
+        endVertices.push_back(endVertex);
+        // Degenerate pieces shorter than the vertex distance are dropped
+        if (startVertex != endVertex || boundary[i].n > 2)
+            outgoing[startVertex].push_back(i);
+    }
+    std::vector<Contour> contours;
+    for (int v = 0; v < (int) outgoing.size(); ++v) {
+        while (!outgoing[v].empty()) {
+            contours.push_back(Contour());
+            Contour &contour = contours.back();
+            int vertex = v;
+            do {
+                if (outgoing[vertex].empty())
+                    return false;
+                int piece = outgoing[vertex].back();
+                outgoing[vertex].pop_back();
+                ControlPoints cp = boundary[piece];
+                cp.p[0] = vertices.position(startVertices[piece]);
+                cp.p[cp.n-1] = vertices.position(endVertices[piece]);
+                contour.addEdge(edgeFromControlPoints(cp));
+                vertex = endVertices[piece];
+            } while (vertex != v);
+        }
+    }
+
+    shape.contours.swap(contours);
+    shape.orientContours();
+    return true;
+}
+
+}
+
 #endif
@@ -6,6 +6,7 @@
 namespace msdfgen {
 
 /// Container for a single edge of dynamic type.
+/// The edge segment is stored inline, so a contour's edges live in one contiguous allocation and copying a shape does not allocate per edge.
 class EdgeHolder {
 
 public:
@@ -13,6 +14,7 @@ public:
     static void swap(EdgeHolder &a, EdgeHolder &b);
 
     EdgeHolder();
+    /// Takes ownership of a heap allocated segment, which is copied into the holder and deleted.
     EdgeHolder(EdgeSegment *segment);
     EdgeHolder(Point2 p0, Point2 p1, EdgeColor edgeColor = WHITE);
     EdgeHolder(Point2 p0, Point2 p1, Point2 p2, EdgeColor edgeColor = WHITE);
@@ -34,7 +36,18 @@ public:
     operator const EdgeSegment *() const;
 
 private:
+    /// Points into storage, or is NULL if the holder is empty.
     EdgeSegment *edgeSegment;
+    union {
+        char linear[sizeof(LinearSegment)];
+        char quadratic[sizeof(QuadraticSegment)];
+        char cubic[sizeof(CubicSegment)];
+        double alignDouble;
+        void *alignPointer;
+    } storage;
+
+    void assign(const EdgeSegment *segment);
+    void clear();
 
 };
 
@@ -4,6 +4,7 @@
 #include "Projection.h"
 #include "Shape.h"
 #include "BitmapRef.hpp"
+#include <vector>
 
 namespace msdfgen {
 
@@ -18,13 +19,21 @@ public:
         /// Texel marked as protected. Protected texels are only given the error flag if they cause inversion artifacts.
         PROTECTED = 2
     };
+    /// The stencil holds a separate bitset for each flag. Every row of a bitset starts at a new word, so that different rows may be modified concurrently.
+    typedef unsigned long long StencilWord;
+
+    /// Returns the size in bytes of the stencil buffer required for a distance field of the given dimensions.
+    static size_t stencilBufferSize(int width, int height);
 
     MSDFErrorCorrection();
-    explicit MSDFErrorCorrection(const BitmapRef<byte, 1> &stencil, const Projection &projection, double range);
+    /// The stencil buffer must be aligned for StencilWord and hold at least stencilBufferSize(width, height) bytes.
+    explicit MSDFErrorCorrection(byte *stencilBuffer, int width, int height, const Projection &projection, double range);
     /// Sets the minimum ratio between the actual and maximum expected distance delta to be considered an error.
     void setMinDeviationRatio(double minDeviationRatio);
     /// Sets the minimum ratio between the pre-correction distance error and the post-correction distance error.
     void setMinImproveRatio(double minImproveRatio);
+    /// Sets the per-texel nearest edge indices recorded by the generator (see ErrorCorrectionConfig::nearestEdgeBuffer), which limit the exact distance evaluation to the edges around each texel.
+    void setNearestEdges(const BitmapConstRef<int, 1> &nearestEdges);
     /// Flags all texels that are interpolated at corners as protected.
     void protectCorners(const Shape &shape);
     /// Flags all texels that contribute to edges as protected.
@@ -32,6 +41,10 @@ public:
     void protectEdges(const BitmapConstRef<float, N> &sdf);
     /// Flags all texels as protected.
     void protectAll();
+    /// Finds tiles of texels which are far from edges (all channels at or beyond the same end of the 0-1 range, or equal to each other) and excludes them from findErrors.
+    /// Correcting such texels could not change their values once clamped, so their potentially expensive artifact tests are skipped.
+    template <int N>
+    void classifyTiles(const BitmapConstRef<float, N> &sdf);
     /// Flags texels that are expected to cause interpolation artifacts based on analysis of the SDF only.
     template <int N>
     void findErrors(const BitmapConstRef<float, N> &sdf);
@@ -41,15 +54,24 @@ public:
     /// Modifies the MSDF so that all texels with the error flag are converted to single-channel.
     template <int N>
     void apply(const BitmapRef<float, N> &sdf) const;
-    /// Returns the stencil in its current state (see Flags).
-    BitmapConstRef<byte, 1> getStencil() const;
+    /// Returns the stencil flags of a texel in their current state (see Flags).
+    int getStencil(int x, int y) const;
 
 private:
-    BitmapRef<byte, 1> stencil;
+    StencilWord *errorBits, *protectedBits;
+    int width, height, wordsPerRow;
     Projection projection;
     double invRange;
     double minDeviationRatio;
     double minImproveRatio;
+    BitmapConstRef<int, 1> nearestEdges;
+    /// Per tile flag set by classifyTiles - nonzero if the tile can be skipped.
+    std::vector<byte> settledTiles;
+    int tileColumns;
+
+    bool isInSettledTile(int x, int y) const;
+    void setFlag(StencilWord *bits, int x, int y);
+    bool hasFlag(const StencilWord *bits, int x, int y) const;
 
 };
 
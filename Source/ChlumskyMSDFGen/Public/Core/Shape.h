@@ -11,6 +11,11 @@ namespace msdfgen {
 #define MSDFGEN_CORNER_DOT_EPSILON .000001
 // The proportional amount by which a curve's control point will be adjusted to eliminate convergent corners.
 #define MSDFGEN_DECONVERGENCE_FACTOR .000001
+// Coverage of a contour's control polygons relative to the square of its bounding box's perimeter below which it is considered to enclose nothing.
+#define MSDFGEN_ZERO_AREA_EPSILON .0000001
+// Distance between control points relative to a contour's bounding box perimeter within which an edge is considered to retrace another one.
+// Allows for rounding errors, and for control points moved by deconvergence at the turns of a contour that retraces itself.
+#define MSDFGEN_RETRACE_EPSILON .00001
 
 /// Vector shape representation.
 class CHLUMSKYMSDFGEN_API Shape {
@@ -35,6 +40,10 @@ public:
     Contour & addContour();
     /// Normalizes the shape geometry for distance field generation.
     void normalize();
+    /// Removes contours that enclose no area, which can't affect the sign of any distance - empty contours, ones whose edges all lie on lines through their first point, and ones that retrace themselves edge for edge.
+    /// Self-intersecting contours whose lobes are wound in opposite directions are kept, even if their signed area is zero.
+    /// Returns the number of edges removed.
+    int removeZeroAreaContours();
     /// Performs basic checks to determine if the object represents a valid shape.
     bool validate() const;
     /// Adjusts the bounding box to fit the shape.
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include "Vector2.h"
+#include "SharedShape.h"
 #include "edge-selectors.h"
 #include "contour-combiners.h"
 
@@ -17,13 +18,18 @@ public:
 
     // Passed shape object must persist until the distance finder is destroyed!
     explicit ShapeDistanceFinder(const Shape &shape);
+    /// Keeps the shared shape alive for the lifetime of the distance finder.
+    explicit ShapeDistanceFinder(const SharedShape &shape);
     /// Finds the distance from origin. Not thread-safe! Is fastest when subsequent queries are close together.
     DistanceType distance(const Point2 &origin);
+    /// Returns the edge nearest to the origin of the last distance query, or NULL if it could not be determined.
+    const EdgeSegment * nearestEdge() const;
 
     /// Finds the distance between shape and origin. Does not allocate result cache used to optimize performance of multiple queries.
     static DistanceType oneShotDistance(const Shape &shape, const Point2 &origin);
 
 private:
+    SharedShape sharedShape;
     const Shape &shape;
     ContourCombiner contourCombiner;
     std::vector<typename ContourCombiner::EdgeSelectorType::EdgeCache> shapeEdgeCache;
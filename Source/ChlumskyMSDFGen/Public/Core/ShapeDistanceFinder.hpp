@@ -6,6 +6,9 @@ namespace msdfgen {
 template <class ContourCombiner>
 ShapeDistanceFinder<ContourCombiner>::ShapeDistanceFinder(const Shape &shape) : shape(shape), contourCombiner(shape), shapeEdgeCache(shape.edgeCount()) { }
 
+template <class ContourCombiner>
+ShapeDistanceFinder<ContourCombiner>::ShapeDistanceFinder(const SharedShape &shape) : sharedShape(shape), shape(*shape), contourCombiner(*shape), shapeEdgeCache(shape->edgeCount()) { }
+
 template <class ContourCombiner>
 typename ShapeDistanceFinder<ContourCombiner>::DistanceType ShapeDistanceFinder<ContourCombiner>::distance(const Point2 &origin) {
     contourCombiner.reset(origin);
@@ -29,6 +32,11 @@ typename ShapeDistanceFinder<ContourCombiner>::DistanceType ShapeDistanceFinder<
     return contourCombiner.distance();
 }
 
+template <class ContourCombiner>
+const EdgeSegment * ShapeDistanceFinder<ContourCombiner>::nearestEdge() const {
+    return contourCombiner.nearestEdge();
+}
+
 template <class ContourCombiner>
 typename ShapeDistanceFinder<ContourCombiner>::DistanceType ShapeDistanceFinder<ContourCombiner>::oneShotDistance(const Shape &shape, const Point2 &origin) {
     ContourCombiner contourCombiner(shape);
@@ -0,0 +1,32 @@
+
+#pragma once
+
+#include <memory>
+#include "Shape.h"
+
+namespace msdfgen {
+
+/// Reference counted handle to a finished, immutable shape.
+/// Copies share the same geometry, so a shape can be handed to several generation jobs, threads or caches without cloning its edges.
+/// Reading through any number of handles concurrently is safe, as nothing can modify the shape once it has been shared.
+class CHLUMSKYMSDFGEN_API SharedShape {
+
+public:
+    SharedShape();
+    /// Shares a copy of shape.
+    explicit SharedShape(const Shape &shape);
+    /// Takes over the contents of shape, which is left empty.
+    explicit SharedShape(Shape &&shape);
+    const Shape & operator*() const;
+    const Shape * operator->() const;
+    /// Returns NULL if the handle is empty.
+    operator const Shape *() const;
+    /// Returns the number of handles sharing the shape.
+    long useCount() const;
+
+private:
+    std::shared_ptr<const Shape> shape;
+
+};
+
+}
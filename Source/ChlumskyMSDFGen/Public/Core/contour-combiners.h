@@ -18,6 +18,8 @@ public:
     void reset(const Point2 &p);
     EdgeSelector & edgeSelector(int i);
     DistanceType distance() const;
+    /// Returns the edge nearest to the point of the last reset by true distance, or NULL if it could not be determined.
+    const EdgeSegment * nearestEdge() const;
 
 private:
     EdgeSelector shapeEdgeSelector;
@@ -36,6 +38,8 @@ public:
     void reset(const Point2 &p);
     EdgeSelector & edgeSelector(int i);
     DistanceType distance() const;
+    /// Returns the edge nearest to the point of the last reset by true distance, or NULL if it could not be determined.
+    const EdgeSegment * nearestEdge() const;
 
 private:
     Point2 p;
@@ -7,6 +7,8 @@
 
 namespace msdfgen {
 
+class EdgeHolder;
+
 // Parameters for iterative search of closest point on a cubic Bezier curve. Increase for higher precision.
 #define MSDFGEN_CUBIC_SEARCH_STARTS 4
 #define MSDFGEN_CUBIC_SEARCH_STEPS 4
@@ -46,7 +48,7 @@ public:
     /// Moves the end point of the edge segment.
     virtual void moveEndPoint(Point2 to) = 0;
     /// Splits the edge segments into thirds which together represent the original edge.
-    virtual void splitInThirds(EdgeSegment *&part1, EdgeSegment *&part2, EdgeSegment *&part3) const = 0;
+    virtual void splitInThirds(EdgeHolder &part1, EdgeHolder &part2, EdgeHolder &part3) const = 0;
 };
 
 /// A line segment.
@@ -68,7 +70,7 @@ public:
     void reverse();
     void moveStartPoint(Point2 to);
     void moveEndPoint(Point2 to);
-    void splitInThirds(EdgeSegment *&part1, EdgeSegment *&part2, EdgeSegment *&part3) const;
+    void splitInThirds(EdgeHolder &part1, EdgeHolder &part2, EdgeHolder &part3) const;
 
 };
 
@@ -91,9 +93,9 @@ public:
     void reverse();
     void moveStartPoint(Point2 to);
     void moveEndPoint(Point2 to);
-    void splitInThirds(EdgeSegment *&part1, EdgeSegment *&part2, EdgeSegment *&part3) const;
+    void splitInThirds(EdgeHolder &part1, EdgeHolder &part2, EdgeHolder &part3) const;
 
-    EdgeSegment * convertToCubic() const;
+    EdgeHolder convertToCubic() const;
 
 };
 
@@ -115,7 +117,7 @@ public:
     void reverse();
     void moveStartPoint(Point2 to);
     void moveEndPoint(Point2 to);
-    void splitInThirds(EdgeSegment *&part1, EdgeSegment *&part2, EdgeSegment *&part3) const;
+    void splitInThirds(EdgeHolder &part1, EdgeHolder &part2, EdgeHolder &part3) const;
 
     void deconverge(int param, double amount);
 
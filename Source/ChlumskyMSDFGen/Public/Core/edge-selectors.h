@@ -28,14 +28,19 @@ public:
         EdgeCache();
     };
 
+    TrueDistanceSelector();
     void reset(const Point2 &p);
     void addEdge(EdgeCache &cache, const EdgeSegment *prevEdge, const EdgeSegment *edge, const EdgeSegment *nextEdge);
     void merge(const TrueDistanceSelector &other);
     DistanceType distance() const;
+    SignedDistance trueDistance() const;
+    /// Returns the edge with the minimum true distance, or NULL if none was found since the last reset.
+    const EdgeSegment * nearestEdge() const;
 
 private:
     Point2 p;
     SignedDistance minDistance;
+    const EdgeSegment *nearEdge;
 
 };
 
@@ -61,6 +66,8 @@ public:
     void merge(const PseudoDistanceSelectorBase &other);
     double computeDistance(const Point2 &p) const;
     SignedDistance trueDistance() const;
+    /// Returns the edge with the minimum true distance, or NULL if none was found since the last reset.
+    const EdgeSegment * nearestEdge() const;
 
 private:
     SignedDistance minTrueDistance;
@@ -98,6 +105,8 @@ public:
     void merge(const MultiDistanceSelector &other);
     DistanceType distance() const;
     SignedDistance trueDistance() const;
+    /// Returns the edge with the minimum true distance across all three channels.
+    const EdgeSegment * nearestEdge() const;
 
 private:
     Point2 p;
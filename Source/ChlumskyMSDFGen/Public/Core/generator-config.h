@@ -12,6 +12,10 @@ struct CHLUMSKYMSDFGEN_API ErrorCorrectionConfig {
     static const double defaultMinDeviationRatio;
     /// The default value of minImproveRatio.
     static const double defaultMinImproveRatio;
+    /// Returns the minimum size in bytes of buffer for an MSDF of the given dimensions.
+    static size_t bufferSize(int width, int height);
+    /// Returns the number of texels which the error correction has flagged as errors (and converted to single-channel) in buffer.
+    static int countErrors(const byte *buffer, int width, int height);
 
     /// Mode of operation.
     enum Mode {
@@ -37,10 +41,14 @@ struct CHLUMSKYMSDFGEN_API ErrorCorrectionConfig {
     double minDeviationRatio;
     /// The minimum ratio between the pre-correction distance error and the post-correction distance error. Has no effect for DO_NOT_CHECK_DISTANCE.
     double minImproveRatio;
-    /// An optional buffer to avoid dynamic allocation. Must have at least as many bytes as the MSDF has pixels.
+    /// An optional buffer for the error correction stencil to avoid dynamic allocation. Must be 8-byte aligned and have at least bufferSize(width, height) bytes.
     byte *buffer;
+    /// An optional buffer with one entry per MSDF pixel. If set, the generator stores the index of each pixel's nearest edge (counted across all contours in order, -1 if unknown),
+    /// and the distance checks of the error correction only evaluate the edges recorded around each texel instead of the whole shape. Has no effect for DO_NOT_CHECK_DISTANCE,
+    /// or with overlap support, where the distance depends on whole contours and the full shape is always evaluated.
+    int *nearestEdgeBuffer;
 
-    inline explicit ErrorCorrectionConfig(Mode mode = EDGE_PRIORITY, DistanceCheckMode distanceCheckMode = CHECK_DISTANCE_AT_EDGE, double minDeviationRatio = defaultMinDeviationRatio, double minImproveRatio = defaultMinImproveRatio, byte *buffer = NULL) : mode(mode), distanceCheckMode(distanceCheckMode), minDeviationRatio(minDeviationRatio), minImproveRatio(minImproveRatio), buffer(buffer) { }
+    inline explicit ErrorCorrectionConfig(Mode mode = EDGE_PRIORITY, DistanceCheckMode distanceCheckMode = CHECK_DISTANCE_AT_EDGE, double minDeviationRatio = defaultMinDeviationRatio, double minImproveRatio = defaultMinImproveRatio, byte *buffer = NULL, int *nearestEdgeBuffer = NULL) : mode(mode), distanceCheckMode(distanceCheckMode), minDeviationRatio(minDeviationRatio), minImproveRatio(minImproveRatio), buffer(buffer), nearestEdgeBuffer(nearestEdgeBuffer) { }
 };
 
 /// The configuration of the distance field generator algorithm.
@@ -20,6 +20,7 @@
 #include "Projection.h"
 #include "Scanline.h"
 #include "Shape.h"
+#include "SharedShape.h"
 #include "BitmapRef.hpp"
 #include "Bitmap.h"
 #include "bitmap-interpolation.hpp"
@@ -50,6 +51,51 @@ void CHLUMSKYMSDFGEN_API generateMSDF(const BitmapRef<float, 3> &output, const S
 /// Generates a multi-channel signed distance field with true distance in the alpha channel. Edge colors must be assigned first.
 void CHLUMSKYMSDFGEN_API generateMTSDF(const BitmapRef<float, 4> &output, const Shape &shape, const Projection &projection, double range, const MSDFGeneratorConfig &config = MSDFGeneratorConfig());
 
+/// The kind of distance field produced by a GeneratorJob.
+enum GeneratorJobType {
+    GENERATE_SDF,
+    GENERATE_PSEUDO_SDF,
+    GENERATE_MSDF,
+    GENERATE_MTSDF
+};
+
+/// A single distance field to be produced by generateBatch.
+struct GeneratorJob {
+    GeneratorJobType type;
+    /// Jobs may share the same shape, which stays alive for as long as any job references it.
+    SharedShape shape;
+    Projection projection;
+    double range;
+    /// Error correction settings are only used by the multi-channel job types.
+    MSDFGeneratorConfig config;
+    /// Output pixels - width*height pixels with 1, 1, 3 or 4 floats each, depending on type.
+    float *pixels;
+    int width, height;
+
+    inline GeneratorJob() : type(GENERATE_SDF), range(1), pixels(NULL), width(0), height(0) { }
+};
+
+/// Aggregate statistics of a generateBatch call.
+struct BatchGeneratorStats {
+    /// Number of jobs in the batch.
+    int jobCount;
+    /// Number of jobs which were split into row tiles.
+    int tiledJobCount;
+    /// Number of scheduled work items.
+    int taskCount;
+    /// Total number of generated pixels.
+    long long pixelCount;
+    /// Wall clock time of the whole batch.
+    double seconds;
+
+    inline BatchGeneratorStats() : jobCount(0), tiledJobCount(0), taskCount(0), pixelCount(0), seconds(0) { }
+    inline double pixelsPerSecond() const { return seconds > 0 ? double(pixelCount)/seconds : 0; }
+};
+
+/// Generates many distance fields at once, spreading the work over all worker threads.
+/// Small jobs are processed whole by a single worker, large ones are split into row tiles, and idle workers pick up remaining items until the batch is done.
+void CHLUMSKYMSDFGEN_API generateBatch(const GeneratorJob *jobs, int jobCount, BatchGeneratorStats *stats = NULL);
+
 // Old version of the function API's kept for backwards compatibility
 void CHLUMSKYMSDFGEN_API generateSDF(const BitmapRef<float, 1> &output, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate, bool overlapSupport = true);
 void CHLUMSKYMSDFGEN_API generatePseudoSDF(const BitmapRef<float, 1> &output, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate, bool overlapSupport = true);
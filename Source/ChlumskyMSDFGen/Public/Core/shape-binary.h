@@ -0,0 +1,63 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Shape.h"
+
+namespace msdfgen {
+
+/// Binary shape format, for caching parsed shapes and reloading them without parsing.
+/// Layout: ShapeBinaryHeader, then flat arrays of
+///   - the end edge index of each contour (uint32_t x contourCount),
+///   - segment types (uint8_t x edgeCount),
+///   - edge colors (uint8_t x edgeCount),
+///   - zero padding to a multiple of 8 bytes,
+///   - point coordinates (double x 2 x pointCount), all control points of each edge in turn.
+/// Values are stored in the native byte order, which the magic and version fields check implicitly.
+struct ShapeBinaryHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t contourCount;
+    uint32_t edgeCount;
+    uint32_t pointCount;
+};
+
+#define MSDFGEN_SHAPE_BINARY_VERSION 1
+#define MSDFGEN_SHAPE_BINARY_INVERSE_Y_AXIS 0x01u
+
+/// Read-only view of a binary shape, referencing the memory it was created from (e.g. a memory-mapped file) without copying it.
+class CHLUMSKYMSDFGEN_API ShapeBinaryView {
+
+public:
+    /// Validates the data. If it does not hold a complete shape of the current version, the view is left empty.
+    ShapeBinaryView(const void *data, size_t size);
+    /// Returns false if the view is empty.
+    bool valid() const;
+    int contourCount() const;
+    int edgeCount() const;
+    bool inverseYAxis() const;
+    /// Returns the index one past the last edge of contour.
+    int contourEnd(int contour) const;
+    EdgeSegment::SegmentType segmentType(int edge) const;
+    EdgeColor edgeColor(int edge) const;
+    /// Returns a point of the flat point array. The data need not be aligned.
+    Point2 point(int index) const;
+    /// Rebuilds the shape into output, replacing its contents.
+    bool read(Shape &output) const;
+
+private:
+    const ShapeBinaryHeader *header;
+    const unsigned char *contourEnds, *types, *colors, *points;
+
+};
+
+/// Returns the number of bytes writeShapeBinary needs for shape.
+size_t CHLUMSKYMSDFGEN_API shapeBinarySize(const Shape &shape);
+/// Serializes shape into output. Returns the number of bytes written, or zero if outputSize is too small.
+size_t CHLUMSKYMSDFGEN_API writeShapeBinary(void *output, size_t outputSize, const Shape &shape);
+/// Deserializes a binary shape into output. Returns false if data does not hold a valid shape.
+bool CHLUMSKYMSDFGEN_API readShapeBinary(const void *data, size_t size, Shape &output);
+
+}
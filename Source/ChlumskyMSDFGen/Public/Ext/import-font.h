@@ -2,6 +2,8 @@
 #pragma once
 
 #include <cstdlib>
+#include <utility>
+#include <vector>
 #include "../core/Shape.h"
 
 namespace msdfgen {
@@ -12,7 +14,7 @@ typedef unsigned unicode_t;
 class FreetypeHandle;
 class FontHandle;
 
-class GlyphIndex {
+class CHLUMSKYMSDFGEN_API GlyphIndex {
 
 public:
     explicit GlyphIndex(unsigned index = 0);
@@ -37,31 +39,37 @@ struct FontMetrics {
 };
 
 /// Initializes the FreeType library.
-FreetypeHandle * initializeFreetype();
+FreetypeHandle CHLUMSKYMSDFGEN_API * initializeFreetype();
 /// Deinitializes the FreeType library.
-void deinitializeFreetype(FreetypeHandle *library);
+void CHLUMSKYMSDFGEN_API deinitializeFreetype(FreetypeHandle *library);
 
 #ifdef FT_FREETYPE_H
 /// Creates a FontHandle from FT_Face that was loaded by the user. destroyFont must still be called but will not affect the FT_Face.
-FontHandle * adoptFreetypeFont(FT_Face ftFace);
+FontHandle CHLUMSKYMSDFGEN_API * adoptFreetypeFont(FT_Face ftFace);
 #endif
 /// Loads a font file and returns its handle.
-FontHandle * loadFont(FreetypeHandle *library, const char *filename);
-/// Loads a font from binary data and returns its handle.
-FontHandle * loadFontData(FreetypeHandle *library, const byte *data, int length);
+FontHandle CHLUMSKYMSDFGEN_API * loadFont(FreetypeHandle *library, const char *filename);
+/// Loads a font from binary data and returns its handle. The data must stay valid until the font is destroyed.
+FontHandle CHLUMSKYMSDFGEN_API * loadFontData(FreetypeHandle *library, const byte *data, int length);
 /// Unloads a font file.
-void destroyFont(FontHandle *font);
+void CHLUMSKYMSDFGEN_API destroyFont(FontHandle *font);
 /// Outputs the metrics of a font file.
-bool getFontMetrics(FontMetrics &metrics, FontHandle *font);
+bool CHLUMSKYMSDFGEN_API getFontMetrics(FontMetrics &metrics, FontHandle *font);
 /// Outputs the width of the space and tab characters.
-bool getFontWhitespaceWidth(double &spaceAdvance, double &tabAdvance, FontHandle *font);
+bool CHLUMSKYMSDFGEN_API getFontWhitespaceWidth(double &spaceAdvance, double &tabAdvance, FontHandle *font);
 /// Outputs the glyph index corresponding to the specified Unicode character.
-bool getGlyphIndex(GlyphIndex &glyphIndex, FontHandle *font, unicode_t unicode);
+bool CHLUMSKYMSDFGEN_API getGlyphIndex(GlyphIndex &glyphIndex, FontHandle *font, unicode_t unicode);
 /// Loads the geometry of a glyph from a font file.
-bool loadGlyph(Shape &output, FontHandle *font, GlyphIndex glyphIndex, double *advance = NULL);
-bool loadGlyph(Shape &output, FontHandle *font, unicode_t unicode, double *advance = NULL);
+/// Unlike the other functions, it may be called from several threads at once. Each thread loads with a face of its own, created from the same file or data,
+/// and decoded glyphs are cached by glyph index until the font is destroyed, so loading a glyph again only copies its outline.
+/// Glyphs of an adopted font are loaded one at a time, as its FT_Face can't be duplicated.
+bool CHLUMSKYMSDFGEN_API loadGlyph(Shape &output, FontHandle *font, GlyphIndex glyphIndex, double *advance = NULL);
+bool CHLUMSKYMSDFGEN_API loadGlyph(Shape &output, FontHandle *font, unicode_t unicode, double *advance = NULL);
 /// Outputs the kerning distance adjustment between two specific glyphs.
-bool getKerning(double &output, FontHandle *font, GlyphIndex glyphIndex1, GlyphIndex glyphIndex2);
-bool getKerning(double &output, FontHandle *font, unicode_t unicode1, unicode_t unicode2);
+bool CHLUMSKYMSDFGEN_API getKerning(double &output, FontHandle *font, GlyphIndex glyphIndex1, GlyphIndex glyphIndex2);
+bool CHLUMSKYMSDFGEN_API getKerning(double &output, FontHandle *font, unicode_t unicode1, unicode_t unicode2);
+/// RTM : Outputs the pairs of glyphs listed by the font's kern table, which are the only ones getKerning can adjust in an SFNT font.
+/// Returns false if the font isn't an SFNT font, whose kerned pairs can't be listed. Kerning in the GPOS table isn't read by getKerning, so it isn't listed either.
+bool CHLUMSKYMSDFGEN_API getKerningPairs(std::vector<std::pair<GlyphIndex, GlyphIndex> > &output, FontHandle *font);
 
 }
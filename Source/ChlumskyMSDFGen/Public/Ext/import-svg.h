@@ -2,17 +2,66 @@
 #pragma once
 
 #include <cstdlib>
+#include <string>
+#include <vector>
 #include "../core/Shape.h"
 
 namespace msdfgen {
 
+/// Default maximum distance of arc approximations from the true arcs, relative to the smaller dimension of the document - a quarter of a texel at 1024 texels
+#define MSDFGEN_DEFAULT_SVG_ARC_TOLERANCE (1/4096.)
+
 /// Builds a shape from an SVG path string
-bool CHLUMSKYMSDFGEN_API buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSnapRange = 0);
+/// Arcs are approximated by as few cubic segments as keep their distance from the true arcs within arcTolerance, in path units.
+/// Without a tolerance, the error is kept within about 0.03% of the arc's radius.
+bool CHLUMSKYMSDFGEN_API buildShapeFromSvgPath(Shape &shape, const char *pathDef, double endpointSnapRange = 0, double arcTolerance = 0);
+
+/// RTM : Numbers of shape elements of an SVG file that were left out of its shape
+struct SvgImportStats {
+    /// Elements hidden by display="none" or zero opacity, of their own or of an ancestor
+    int hiddenElements;
+    /// Elements without any geometry, e.g. with a zero size or too few points
+    int emptyElements;
+    /// Whether the import failed because <use> references would place more edges than the importer allows
+    bool placedEdgeLimitExceeded;
+
+    SvgImportStats() : hiddenElements(0), emptyElements(0), placedEdgeLimitExceeded(false) { }
+};
 
 /// RTM : Creates a shape from a preloaded SVG file
-bool CHLUMSKYMSDFGEN_API buildShapeFromSvgFileBuffer(Shape &output, const char* file, size_t fileLength, int pathIndex = 0, Vector2 *dimensions = NULL);
+/// The file is read in place without being copied, and need not be null-terminated.
+/// All paths and basic shapes (rect, circle, ellipse, polygon and polyline) of the document, including those nested in groups, are combined into one shape if pathIndex is 0.
+/// Otherwise only a single element is read - counting from 1 in document order, or from -1 backwards from the last one.
+/// Transform attributes, the root viewBox and <use> references are applied, and every <use> of an element counts as a separate element.
+/// The import fails if all instances together would have more edges than the importer allows, which is noted in stats.
+/// Hidden elements are skipped without being built, and elements without geometry are left out. Their numbers are stored in stats.
+/// Arcs, circles and ellipses are approximated within arcTolerance, relative to the smaller of the document's dimensions - e.g. 0.5/1024 for half a texel of a 1024 texel SDF.
+/// Elements are combined under the non-zero fill rule, so each one's contours are reversed if its total area is negative - otherwise it would cancel out the fill of elements it overlaps.
+/// With resolveElements, elements of a moderate size have their geometry resolved on their own instead.
+bool CHLUMSKYMSDFGEN_API buildShapeFromSvgFileBuffer(Shape &output, const char* file, size_t fileLength, int pathIndex = 0, Vector2 *dimensions = NULL, double arcTolerance = MSDFGEN_DEFAULT_SVG_ARC_TOLERANCE, SvgImportStats *stats = NULL, bool resolveElements = false);
 	
-/// Reads the first path found in the specified SVG file and stores it as a Shape in output.
-bool CHLUMSKYMSDFGEN_API loadSvgShape(Shape &output, const char *filename, int pathIndex = 0, Vector2 *dimensions = NULL);
+/// Reads the shape elements of the specified SVG file and stores them as a Shape in output, selected by pathIndex as in buildShapeFromSvgFileBuffer.
+/// The file is streamed in chunks, so apart from the resulting shape, memory use is bounded by the largest single element rather than the file size.
+bool CHLUMSKYMSDFGEN_API loadSvgShape(Shape &output, const char *filename, int pathIndex = 0, Vector2 *dimensions = NULL, double arcTolerance = MSDFGEN_DEFAULT_SVG_ARC_TOLERANCE, SvgImportStats *stats = NULL, bool resolveElements = false);
+
+/// RTM : A sprite of an SVG sprite sheet, read by buildShapesFromSvgSpriteSheet
+struct SvgSprite {
+    /// The id of the element the sprite was read from
+    std::string id;
+    /// The sprite's geometry, which lies between the origin and dimensions
+    Shape shape;
+    Vector2 dimensions;
+    /// Whether the dimensions are those of a symbol's viewBox, rather than the bounds of the geometry
+    bool viewBox;
+};
+
+/// RTM : Reads every <symbol> with an id, and every group with an id directly inside the root or its <defs>, of a preloaded SVG file as a separate shape.
+/// The document is parsed once for all sprites, and the document's own content is not built. Sprites are returned in document order, leaving out those without any geometry.
+/// Arcs are approximated within arcTolerance relative to the smaller of each symbol's viewBox dimensions. Groups aren't sized until they are built, so their arcs are approximated within about 0.03% of their radii.
+/// Elements are oriented, or resolved with resolveElements, as in buildShapeFromSvgFileBuffer, and the import fails if the sprites together would have more edges than the importer allows.
+bool CHLUMSKYMSDFGEN_API buildShapesFromSvgSpriteSheet(std::vector<SvgSprite> &output, const char *file, size_t fileLength, double arcTolerance = MSDFGEN_DEFAULT_SVG_ARC_TOLERANCE, SvgImportStats *stats = NULL, bool resolveElements = false);
+
+/// Reads the sprites of the specified SVG file as in buildShapesFromSvgSpriteSheet, streaming the file in chunks.
+bool CHLUMSKYMSDFGEN_API loadSvgSpriteSheet(std::vector<SvgSprite> &output, const char *filename, double arcTolerance = MSDFGEN_DEFAULT_SVG_ARC_TOLERANCE, SvgImportStats *stats = NULL, bool resolveElements = false);
 
 }
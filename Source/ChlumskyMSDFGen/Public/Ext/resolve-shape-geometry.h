@@ -3,13 +3,12 @@
 
 #include "../core/Shape.h"
 
-#ifdef MSDFGEN_USE_SKIA
-
 namespace msdfgen {
 
-/// Resolves any intersections within the shape by subdividing its contours using the Skia library and makes sure its contours have a consistent winding.
-bool resolveShapeGeometry(Shape &shape);
+/// Resolves any intersections within the shape by subdividing its contours and makes sure its contours have a consistent winding.
+/// Overlapping parts of the non-zero fill are merged, so the result can be generated without overlap support.
+/// Uses the Skia library if MSDFGEN_USE_SKIA is defined, otherwise a native implementation.
+/// Returns false and leaves the shape untouched if its geometry could not be resolved, e.g. because it has open or coincident curved contours.
+bool CHLUMSKYMSDFGEN_API resolveShapeGeometry(Shape &shape);
 
 }
-
-#endif
@@ -0,0 +1,9 @@
+// Copyright (c) Richard Meredith AB. All Rights Reserved
+
+#include "Font/RTMSDFFontData.h"
+
+float URTMSDFFontData::GetKerning(int32 first, int32 second) const
+{
+	const float* kerning = Kerning.Find(MakeKerningKey(first, second));
+	return kerning ? *kerning : 0.0f;
+}
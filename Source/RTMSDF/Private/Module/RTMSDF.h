@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include "Logging/LogMacros.h"
+#include "Modules/ModuleInterface.h"
+
 DECLARE_LOG_CATEGORY_EXTERN(RTMSDF, All, All)
 
 class FRTMSDFModule : public IModuleInterface
@@ -0,0 +1,77 @@
+// Copyright (c) Richard Meredith AB. All Rights Reserved
+
+#pragma once
+
+#include "Engine/DataAsset.h"
+#include "Engine/Texture2D.h"
+
+#include "RTMSDFFontData.generated.h"
+
+// A glyph of an SDF font atlas. All metrics are in ems, relative to the pen position on the baseline, with Y pointing up
+USTRUCT(BlueprintType)
+struct RTMSDF_API FRTMSDFGlyph
+{
+	GENERATED_BODY()
+
+	// Horizontal distance to the next pen position
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Glyph")
+	float Advance = 0.0f;
+
+	// The quad to draw the glyph's atlas cell to, including its distance range. Invalid for glyphs without an outline, such as spaces
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Glyph")
+	FBox2D PlaneBounds = FBox2D(ForceInit);
+
+	// The glyph's cell of the atlas. Min is the top left corner, matching PlaneBounds.Min.X and PlaneBounds.Max.Y
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Glyph")
+	FBox2D UVs = FBox2D(ForceInit);
+};
+
+// Glyph metrics and kerning of an SDF font atlas imported from a .ttf or .otf file
+UCLASS(BlueprintType, meta=(DisplayName="SDF Font Data [RTMSDF]"))
+class RTMSDF_API URTMSDFFontData : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Font")
+	TSoftObjectPtr<UTexture2D> Atlas;
+
+	// Texels per em in the atlas
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Font")
+	float GlyphSize = 0.0f;
+
+	// Width of the distance range around each glyph's outline, in ems. Multiply by GlyphSize for the range in atlas texels
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Font")
+	float DistanceRange = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Font")
+	float Ascender = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Font")
+	float Descender = 0.0f;
+
+	// Vertical distance between consecutive baselines
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Font")
+	float LineHeight = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Font")
+	float UnderlineY = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Font")
+	float UnderlineThickness = 0.0f;
+
+	// Glyphs by Unicode code point
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Font")
+	TMap<int32, FRTMSDFGlyph> Glyphs;
+
+	// Adjustments to the advance between pairs of code points, keyed by MakeKerningKey. Pairs without an adjustment are left out
+	UPROPERTY(VisibleAnywhere, Category="Font")
+	TMap<int64, float> Kerning;
+
+	static int64 MakeKerningKey(int32 first, int32 second) { return (int64)first << 32 | (uint32)second; }
+
+	const FRTMSDFGlyph* FindGlyph(int32 codePoint) const { return Glyphs.Find(codePoint); }
+
+	UFUNCTION(BlueprintPure, Category="RTMSDF|Font")
+	float GetKerning(int32 first, int32 second) const;
+};
@@ -4,6 +4,7 @@
 
 #include "Engine/TextureDefines.h"
 #include "Importer/Bitmap/RTMSDF_BitmapImportSettings.h"
+#include "Importer/Font/RTMSDF_FontImportSettings.h"
 #include "Importer/SVG/RTMSDF_SVGImportSettings.h"
 #include "UObject/Object.h"
 
@@ -18,6 +19,14 @@ public:
 	UPROPERTY(Config, EditAnywhere, Category="SVG File Rules", meta=(DisplayName="SVG Filename Suffix"))
 	FString SVGFilenameSuffix = "_SDF";
 
+	/* Keep parsed SVG shapes in Saved/RTMSDF, so reimports of unchanged files can skip parsing */
+	UPROPERTY(Config, EditAnywhere, Category="SVG File Rules")
+	bool CacheParsedShapes = true;
+
+	/* Once the cached shapes take up more than this, the least recently used ones are deleted */
+	UPROPERTY(Config, EditAnywhere, Category="SVG File Rules", meta=(EditCondition="CacheParsedShapes", DisplayName="Shape Cache Size Limit (MB)", UIMin=1, ClampMin=1))
+	int32 ShapeCacheSizeLimitMB = 256;
+
 	UPROPERTY(Config, EditAnywhere, Category="SVG Default Import Settings")
 	TEnumAsByte<TextureGroup> SVGTextureGroup = TEXTUREGROUP_UI;
 
@@ -32,4 +41,13 @@ public:
 
 	UPROPERTY(Config, EditAnywhere, Category="Bitmap Default Import Settings", meta=(FullyExpand=true, DisplayName = "Default SVG Import Settings"))
 	FRTMSDF_BitmapImportSettings DefaultBitmapImportSettings;
+
+	UPROPERTY(Config, EditAnywhere, Category="Font File Rules", meta=(DisplayName="Font Filename Suffix"))
+	FString FontFilenameSuffix = "_SDF";
+
+	UPROPERTY(Config, EditAnywhere, Category="Font Default Import Settings")
+	TEnumAsByte<TextureGroup> FontTextureGroup = TEXTUREGROUP_UI;
+
+	UPROPERTY(Config, EditAnywhere, Category="Font Default Import Settings", meta=(FullyExpand=true, DisplayName = "Default Font Import Settings"))
+	FRTMSDF_FontImportSettings DefaultFontImportSettings;
 };
@@ -0,0 +1,607 @@
+﻿// Copyright (c) Richard Meredith AB. All Rights Reserved
+
+#include "RTMSDF_FontFactory.h"
+#include "Async/ParallelFor.h"
+#include "ChlumskyMSDFGen/Public/Core/msdfgen.h"
+#include "ChlumskyMSDFGen/Public/Ext/import-font.h"
+#include "Config/RTMSDFConfig.h"
+#include "Curves/CurveLinearColorAtlas.h"
+#include "Editor.h"
+#include "EditorFramework/AssetImportData.h"
+#include "Font/RTMSDFFontData.h"
+#include "HAL/FileManager.h"
+#include "Hash/CityHash.h"
+#include "Importer/RTMSDFTextureSettingsCache.h"
+#include "Importer/SVG/RTMSDF_SVGGenerationHelpers.h"
+#include "Misc/Paths.h"
+#include "Module/RTMSDFEditor.h"
+#include "RTMSDF_FontImportAssetData.h"
+#include "RTMSDF_FontImportSettings.h"
+
+#if ENGINE_MAJOR_VERSION >=5 && ENGINE_MINOR_VERSION >=2
+#include "TextureReferenceResolver.h"
+#endif
+
+namespace RTM::SDF::FontFactoryStatics
+{
+	using namespace msdfgen;
+	using namespace RTMSDFGenerationHelpers;
+
+	struct FCodePointRange
+	{
+		ERTMSDFCharacterSet Set;
+		unicode_t First;
+		unicode_t Last;
+	};
+
+	constexpr FCodePointRange CharacterSetRanges[] =
+	{
+		{ERTMSDFCharacterSet::BasicLatin, 0x20, 0x7e},
+		{ERTMSDFCharacterSet::Latin, 0xa0, 0x24f},
+		{ERTMSDFCharacterSet::Greek, 0x370, 0x3ff},
+		{ERTMSDFCharacterSet::Cyrillic, 0x400, 0x52f},
+		{ERTMSDFCharacterSet::CJK, 0x3000, 0x30ff},
+		{ERTMSDFCharacterSet::CJK, 0x4e00, 0x9fff},
+		{ERTMSDFCharacterSet::CJK, 0xff00, 0xffef},
+	};
+
+	// Without a kern table to list the kerned pairs of, kerning is looked up between every pair of glyphs below this code point - pairs grow quadratically, and CJK ideographs aren't kerned
+	constexpr unicode_t KerningCodePointLimit = 0x2e80;
+
+	// Largest texture the engine can hold
+	constexpr int32 MaxAtlasSize = 16384;
+
+	// A font file loaded into FreeType, along with the copy of the file its faces read from
+	struct FLoadedFont
+	{
+		uint64 Hash = 0;
+		TArray<uint8> Data;
+		FreetypeHandle* Library = nullptr;
+		FontHandle* Font = nullptr;
+
+		~FLoadedFont()
+		{
+			if(Font)
+				destroyFont(Font);
+			if(Library)
+				deinitializeFreetype(Library);
+		}
+	};
+
+	// The most recently imported font stays loaded, so reimporting it with different settings reuses the glyph outlines it has already decoded
+	TUniquePtr<FLoadedFont> LastLoadedFont;
+
+	FontHandle* LoadFont(const uint8* buffer, const uint8* bufferEnd)
+	{
+		const int64 size = bufferEnd - buffer;
+		const uint64 hash = CityHash64(reinterpret_cast<const char*>(buffer), size);
+		if(LastLoadedFont && LastLoadedFont->Hash == hash && LastLoadedFont->Data.Num() == size)
+			return LastLoadedFont->Font;
+
+		LastLoadedFont.Reset();
+		TUniquePtr<FLoadedFont> loadedFont = MakeUnique<FLoadedFont>();
+		loadedFont->Hash = hash;
+		loadedFont->Data.Append(buffer, size);
+		loadedFont->Library = initializeFreetype();
+		loadedFont->Font = loadedFont->Library ? loadFontData(loadedFont->Library, loadedFont->Data.GetData(), loadedFont->Data.Num()) : nullptr;
+		if(!loadedFont->Font)
+			return nullptr;
+
+		LastLoadedFont = MoveTemp(loadedFont);
+		return LastLoadedFont->Font;
+	}
+
+	// A distinct glyph of the font - code points the font maps to the same glyph share it
+	struct FGlyphSlot
+	{
+		GlyphIndex Index;
+		Shape Outline;
+		double Advance = 0.0;
+		bool Loaded = false;
+		bool ResolvedGeometry = false;
+		Projection GlyphProjection;
+		// The glyph's cell of the atlas, in texels. Glyphs without an outline have no cell
+		int32 X = 0;
+		int32 Y = 0;
+		int32 Width = 0;
+		int32 Height = 0;
+	};
+
+	struct FFontAtlas
+	{
+		int32 Width = 0;
+		int32 Height = 0;
+		TArray<uint8> Pixels;
+		double Range = 0.0;
+		TMap<int32, FRTMSDFGlyph> Glyphs;
+		TMap<int64, float> Kerning;
+	};
+
+	TArray<unicode_t> GetCodePoints(const FRTMSDF_FontImportSettings& settings)
+	{
+		TSet<unicode_t> codePoints;
+		for(const FCodePointRange& range : CharacterSetRanges)
+		{
+			if(settings.CharacterSets & static_cast<uint8>(range.Set))
+			{
+				for(unicode_t codePoint = range.First; codePoint <= range.Last; codePoint++)
+					codePoints.Add(codePoint);
+			}
+		}
+
+		// Characters outside of the basic multilingual plane are stored as surrogate pairs
+		const FString& characters = settings.AdditionalCharacters;
+		for(int32 i = 0; i < characters.Len(); i++)
+		{
+			unicode_t codePoint = (unicode_t)characters[i];
+			if(codePoint >= 0xd800 && codePoint < 0xdc00 && i + 1 < characters.Len() && characters[i + 1] >= 0xdc00 && characters[i + 1] < 0xe000)
+				codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + ((unicode_t)characters[++i] - 0xdc00);
+			if(codePoint >= 0x20)
+				codePoints.Add(codePoint);
+		}
+
+		TArray<unicode_t> sortedCodePoints = codePoints.Array();
+		sortedCodePoints.Sort();
+		return sortedCodePoints;
+	}
+
+	// Packs the glyph cells into rows of a fixed width, tallest first. Returns the height of the packed rows
+	int32 PackShelves(TArray<FGlyphSlot>& glyphs, int32 atlasWidth, int32 padding)
+	{
+		TArray<int32> order;
+		for(int32 i = 0; i < glyphs.Num(); i++)
+		{
+			if(glyphs[i].Width > 0)
+				order.Add(i);
+		}
+		order.Sort([&](int32 a, int32 b) { return glyphs[a].Height != glyphs[b].Height ? glyphs[a].Height > glyphs[b].Height : glyphs[a].Width > glyphs[b].Width; });
+
+		int32 x = padding, y = padding, shelfHeight = 0;
+		for(int32 i : order)
+		{
+			FGlyphSlot& glyph = glyphs[i];
+			if(x + glyph.Width + padding > atlasWidth)
+			{
+				x = padding;
+				y += shelfHeight + padding;
+				shelfHeight = 0;
+			}
+			glyph.X = x;
+			glyph.Y = y;
+			x += glyph.Width + padding;
+			shelfHeight = FMath::Max(shelfHeight, glyph.Height);
+		}
+		return y + shelfHeight + padding;
+	}
+
+	bool BuildFontAtlas(FontHandle* font, const FontMetrics& metrics, const FRTMSDF_FontImportSettings& settings, const FString& sourceName, FFontAtlas& outAtlas)
+	{
+		const double startTime = FPlatformTime::Seconds();
+		const TArray<unicode_t> codePoints = GetCodePoints(settings);
+
+		TArray<FGlyphSlot> glyphs;
+		TArray<int32> codePointGlyphs;
+		TMap<unsigned, int32> glyphSlots;
+		codePointGlyphs.Init(INDEX_NONE, codePoints.Num());
+		for(int32 i = 0; i < codePoints.Num(); i++)
+		{
+			GlyphIndex glyphIndex;
+			if(!getGlyphIndex(glyphIndex, font, codePoints[i]))
+				continue;
+
+			if(const int32* slot = glyphSlots.Find(glyphIndex.getIndex()))
+			{
+				codePointGlyphs[i] = *slot;
+				continue;
+			}
+
+			FGlyphSlot& glyph = glyphs.AddDefaulted_GetRef();
+			glyph.Index = glyphIndex;
+			codePointGlyphs[i] = glyphSlots.Add(glyphIndex.getIndex(), glyphs.Num() - 1);
+		}
+
+		const double scale = settings.GlyphSize / metrics.emSize;
+		const double range = GetDistanceRange(settings, Vector2(metrics.emSize), scale);
+		const bool multichannel = settings.Format == ERTMSDFFormat::Multichannel || settings.Format == ERTMSDFFormat::MultichannelPlusAlpha;
+		const double angleThreshold = FMath::DegreesToRadians(settings.MaxCornerAngle);
+
+		// loadGlyph gives each worker a face of its own, so outlines are read in parallel too
+		FThreadSafeCounter loadedGlyphs, unresolvedGlyphs;
+		ParallelFor(glyphs.Num(), [&](int32 i)
+		{
+			FGlyphSlot& glyph = glyphs[i];
+			Shape& outline = glyph.Outline;
+			glyph.Loaded = loadGlyph(outline, font, glyph.Index, &glyph.Advance);
+			if(!glyph.Loaded)
+				return;
+
+			loadedGlyphs.Increment();
+			if(!PrepareGlyphOutline(outline, settings.ResolveGeometry, glyph.ResolvedGeometry))
+				return;
+			if(settings.ResolveGeometry && !glyph.ResolvedGeometry)
+				unresolvedGlyphs.Increment();
+			if(multichannel)
+				DoEdgeColoring(outline, settings.EdgeColoringMode, angleThreshold, settings.EdgeColoringSeed);
+
+			// Each cell fits the outline plus half the distance range on every side, with the outline centred in it
+			const Shape::Bounds bounds = outline.getBounds();
+			const Vector2 outlineDims(bounds.r - bounds.l, bounds.t - bounds.b);
+			glyph.Width = FMath::CeilToInt((outlineDims.x + range) * scale);
+			glyph.Height = FMath::CeilToInt((outlineDims.y + range) * scale);
+			const Vector2 translate = 0.5 * (Vector2(glyph.Width, glyph.Height) / scale - outlineDims) - Vector2(bounds.l, bounds.b);
+			glyph.GlyphProjection = Projection(Vector2(scale), translate);
+		});
+
+		if(loadedGlyphs.GetValue() == 0)
+			return false;
+
+		if(unresolvedGlyphs.GetValue() > 0)
+			UE_LOG(RTMSDFEditor, Log, TEXT("Unable to resolve overlapping geometry of %d glyphs of %s - falling back to overlap support"), unresolvedGlyphs.GetValue(), *sourceName);
+
+		// A power of two wide atlas of about the cells' total area, with the height trimmed to the packed rows
+		const int32 padding = FMath::Max(settings.GlyphPadding, 0);
+		int64 cellArea = 0;
+		int32 widestCell = 0;
+		for(const FGlyphSlot& glyph : glyphs)
+		{
+			if(glyph.Width > 0)
+			{
+				cellArea += (int64)(glyph.Width + padding) * (glyph.Height + padding);
+				widestCell = FMath::Max(widestCell, glyph.Width);
+			}
+		}
+		outAtlas.Width = FMath::Max((int32)FMath::RoundUpToPowerOfTwo((uint32)FMath::CeilToInt(FMath::Sqrt((double)cellArea))), widestCell + 2 * padding);
+		outAtlas.Height = Align(FMath::Max(PackShelves(glyphs, outAtlas.Width, padding), 1), 4);
+		if(outAtlas.Width > MaxAtlasSize || outAtlas.Height > MaxAtlasSize)
+		{
+			UE_LOG(RTMSDFEditor, Error, TEXT("Import for %s failed - a %dx%d atlas is larger than the largest texture, reduce the Glyph Size or the character sets"), *sourceName, outAtlas.Width, outAtlas.Height);
+			return false;
+		}
+
+		// Glyphs that couldn't be resolved use the first config, with overlap support
+		MSDFGeneratorConfig generatorConfigs[2];
+		for(int32 i = 0; i < 2; i++)
+		{
+			generatorConfigs[i].overlapSupport = i == 0;
+			ApplyErrorCorrectionModeTo(generatorConfigs[i].errorCorrection, settings.ErrorCorrectionMode);
+		}
+
+		TArray<FRTMSDFGenerationJob> jobs;
+		TArray<int32> jobGlyphs;
+		TArray<TArray<uint8>> pixels;
+		pixels.SetNum(glyphs.Num());
+		for(int32 i = 0; i < glyphs.Num(); i++)
+		{
+			FGlyphSlot& glyph = glyphs[i];
+			if(glyph.Width == 0)
+				continue;
+
+			FRTMSDFGenerationJob& job = jobs.AddDefaulted_GetRef();
+			job.Format = settings.Format;
+			job.GeneratorConfig = &generatorConfigs[glyph.ResolvedGeometry ? 1 : 0];
+			job.Shape = SharedShape(MoveTemp(glyph.Outline));
+			job.Projection = &glyph.GlyphProjection;
+			job.Width = glyph.Width;
+			job.Height = glyph.Height;
+			job.Range = range;
+			job.InvertDistance = settings.InvertDistance;
+			job.OutPixels = &pixels[i];
+			jobGlyphs.Add(i);
+		}
+
+		GenerateBatch(jobs);
+
+		const int32 texelSize = multichannel ? 4 : 1;
+		outAtlas.Pixels.Init(settings.InvertDistance ? 255 : 0, outAtlas.Width * outAtlas.Height * texelSize);
+		if(settings.Format == ERTMSDFFormat::Multichannel)
+		{
+			for(int32 i = 3; i < outAtlas.Pixels.Num(); i += 4)
+				outAtlas.Pixels[i] = 255;
+		}
+
+		// Font outlines point Y up, so the generated rows are flipped into the atlas
+		ParallelFor(jobGlyphs.Num(), [&](int32 j)
+		{
+			const FGlyphSlot& glyph = glyphs[jobGlyphs[j]];
+			const TArray<uint8>& cell = pixels[jobGlyphs[j]];
+			if(cell.Num() != glyph.Width * glyph.Height * texelSize)
+				return;
+
+			for(int32 row = 0; row < glyph.Height; row++)
+				FMemory::Memcpy(&outAtlas.Pixels[((glyph.Y + glyph.Height - 1 - row) * outAtlas.Width + glyph.X) * texelSize], &cell[row * glyph.Width * texelSize], glyph.Width * texelSize);
+		});
+
+		// Code points the font has no glyph for, or whose glyph couldn't be read, are left out
+		int32 missingGlyphs = 0;
+		for(int32& glyph : codePointGlyphs)
+		{
+			if(glyph != INDEX_NONE && !glyphs[glyph].Loaded)
+				glyph = INDEX_NONE;
+			if(glyph == INDEX_NONE)
+				missingGlyphs++;
+		}
+
+		outAtlas.Range = range / metrics.emSize;
+		for(int32 i = 0; i < codePoints.Num(); i++)
+		{
+			if(codePointGlyphs[i] == INDEX_NONE)
+				continue;
+
+			const FGlyphSlot& glyph = glyphs[codePointGlyphs[i]];
+			FRTMSDFGlyph& record = outAtlas.Glyphs.Add((int32)codePoints[i]);
+			record.Advance = (float)(glyph.Advance / metrics.emSize);
+			if(glyph.Width > 0)
+			{
+				const Point2 bottomLeft = glyph.GlyphProjection.unproject(Point2(0.0, 0.0)) / metrics.emSize;
+				const Point2 topRight = glyph.GlyphProjection.unproject(Point2(glyph.Width, glyph.Height)) / metrics.emSize;
+				record.PlaneBounds = FBox2D(FVector2D(bottomLeft.x, bottomLeft.y), FVector2D(topRight.x, topRight.y));
+				record.UVs = FBox2D(FVector2D((double)glyph.X / outAtlas.Width, (double)glyph.Y / outAtlas.Height), FVector2D((double)(glyph.X + glyph.Width) / outAtlas.Width, (double)(glyph.Y + glyph.Height) / outAtlas.Height));
+			}
+		}
+
+		if(settings.ImportKerning)
+		{
+			auto addKerning = [&](int32 first, int32 second)
+			{
+				double kerning;
+				if(getKerning(kerning, font, glyphs[codePointGlyphs[first]].Index, glyphs[codePointGlyphs[second]].Index) && kerning != 0.0)
+					outAtlas.Kerning.Add(URTMSDFFontData::MakeKerningKey((int32)codePoints[first], (int32)codePoints[second]), (float)(kerning / metrics.emSize));
+			};
+
+			std::vector<std::pair<GlyphIndex, GlyphIndex>> kerningPairs;
+			if(getKerningPairs(kerningPairs, font))
+			{
+				// Pairs are listed by glyph, and several code points may share one
+				TMultiMap<uint32, int32> glyphCodePoints;
+				for(int32 i = 0; i < codePoints.Num(); i++)
+				{
+					if(codePointGlyphs[i] != INDEX_NONE)
+						glyphCodePoints.Add(glyphs[codePointGlyphs[i]].Index.getIndex(), i);
+				}
+
+				for(const std::pair<GlyphIndex, GlyphIndex>& pair : kerningPairs)
+				{
+					for(auto first = glyphCodePoints.CreateConstKeyIterator(pair.first.getIndex()); first; ++first)
+					{
+						for(auto second = glyphCodePoints.CreateConstKeyIterator(pair.second.getIndex()); second; ++second)
+							addKerning(first.Value(), second.Value());
+					}
+				}
+			}
+			else
+			{
+				TArray<int32> kernedCodePoints;
+				for(int32 i = 0; i < codePoints.Num() && codePoints[i] < KerningCodePointLimit; i++)
+				{
+					if(codePointGlyphs[i] != INDEX_NONE)
+						kernedCodePoints.Add(i);
+				}
+
+				for(int32 first : kernedCodePoints)
+				{
+					for(int32 second : kernedCodePoints)
+						addKerning(first, second);
+				}
+			}
+		}
+
+		UE_LOG(RTMSDFEditor, Log, TEXT("Built a %dx%d atlas of %d glyphs (%d code points, %d missing from the font, %d kerning pairs) for %s in %.2f milliseconds"),
+			outAtlas.Width, outAtlas.Height, jobs.Num(), outAtlas.Glyphs.Num(), missingGlyphs, outAtlas.Kerning.Num(), *sourceName, (FPlatformTime::Seconds() - startTime) * 1000.0);
+		return true;
+	}
+}
+
+URTMSDF_FontFactory::URTMSDF_FontFactory()
+{
+	bCreateNew = false;
+	bEditorImport = true;
+
+	SupportedClass = UTexture2D::StaticClass();
+	Formats.Add("ttf;TrueType Font");
+	Formats.Add("otf;OpenType Font");
+
+	// The engine's own font importer takes the same extensions, so SDF filenames are claimed before it can get hold of them
+	ImportPriority = INT32_MAX;
+}
+
+bool URTMSDF_FontFactory::IsAutomatedImport() const
+{
+	return Super::IsAutomatedImport() || IsAutomatedReimport();
+}
+
+bool URTMSDF_FontFactory::FactoryCanImport(const FString& filename)
+{
+	if(const auto* settings = GetDefault<URTMSDFConfig>())
+	{
+		const auto& suffix = settings->FontFilenameSuffix;
+		if(suffix.Len() == 0 || FPaths::GetBaseFilename(filename).EndsWith(suffix))
+			return true;
+	}
+	return false;
+}
+
+UObject* URTMSDF_FontFactory::FactoryCreateBinary(UClass* inClass, UObject* inParent, FName inName, EObjectFlags flags, UObject* context, const TCHAR* type, const uint8*& buffer, const uint8* bufferEnd, FFeedbackContext* warn)
+{
+	using namespace msdfgen;
+	using namespace RTMSDFGenerationHelpers;
+	using namespace RTM::SDF::FontFactoryStatics;
+
+	GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPreImport(this, inClass, inParent, inName, type);
+
+	auto existingTexture = FindObject<UTexture2D>(inParent, *inName.ToString());
+
+	if(existingTexture)
+	{
+		existingTexture->UpdateResource();
+		existingTexture->WaitForPendingInitOrStreaming();
+	}
+	else if(!FactoryCanImport(inName.ToString()))
+	{
+		// Unreal will still try to use us if if we tell it not to, if there are no back up factories to use, so we double check here
+		UE_LOG(RTMSDFEditor, Error, TEXT("Import for %s failed - Filename does not match the correct format"), *inName.ToString());
+		return nullptr;
+	}
+
+	FTextureReferenceReplacer RefReplacer(existingTexture);
+	FRTMSDFTextureSettingsCache textureSettings(existingTexture);
+	FRTMSDF_FontImportSettings importerSettings;
+	if(const auto* previousSettings = existingTexture ? existingTexture->GetAssetUserData<URTMSDF_FontImportAssetData>() : nullptr)
+	{
+		importerSettings = previousSettings->ImportSettings;
+	}
+	else if(const auto* defaultConfig = GetDefault<URTMSDFConfig>())
+	{
+		importerSettings = defaultConfig->DefaultFontImportSettings;
+		textureSettings.LODGroup = defaultConfig->FontTextureGroup;
+	}
+
+	FontHandle* font = LoadFont(buffer, bufferEnd);
+	FontMetrics metrics;
+	if(!font || !getFontMetrics(metrics, font) || metrics.emSize <= 0.0)
+	{
+		UE_LOG(RTMSDFEditor, Error, TEXT("Import for %s failed - unable to load the font"), *inName.ToString());
+		GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPostImport(this, nullptr);
+		return nullptr;
+	}
+
+	FFontAtlas atlas;
+	if(!BuildFontAtlas(font, metrics, importerSettings, inName.ToString(), atlas))
+	{
+		UE_LOG(RTMSDFEditor, Error, TEXT("Import for %s failed - unable to create the glyph atlas"), *inName.ToString());
+		GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPostImport(this, nullptr);
+		return nullptr;
+	}
+
+	UTexture2D* texture = nullptr;
+	if(auto newObject = CreateOrOverwriteAsset(inClass, inParent, inName, flags))
+		texture = CastChecked<UTexture2D>(newObject);
+
+	// NOTE: existingTexture will now point to the new texture - don't try to use it's values after this
+
+	if(!texture)
+	{
+		if(existingTexture)
+			existingTexture->UpdateResource();
+
+		UE_LOG(RTMSDFEditor, Error, TEXT("Import for %s failed - unable to create Texture"), *inName.ToString());
+		GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPostImport(this, nullptr);
+		return nullptr;
+	}
+
+	const bool multichannel = importerSettings.Format == ERTMSDFFormat::Multichannel || importerSettings.Format == ERTMSDFFormat::MultichannelPlusAlpha;
+	texture->Source.Init(atlas.Width, atlas.Height, 1, 1, multichannel ? TSF_BGRA8 : TSF_G8, atlas.Pixels.GetData());
+
+	if(!existingTexture)
+	{
+		UE_LOG(RTMSDFEditor, Log, TEXT("Fresh import of %s - applying default SDF settings"), *texture->GetPathName())
+	}
+
+	UpdateNewTextureSettings(texture, textureSettings, importerSettings.Format);
+
+	texture->AssetImportData->Update(CurrentFilename, FileHash.IsValid() ? &FileHash : nullptr);
+
+	auto importData = texture->GetAssetUserData<URTMSDF_FontImportAssetData>();
+	if(!importData)
+	{
+		importData = NewObject<URTMSDF_FontImportAssetData>(texture, NAME_None, flags);
+		texture->AddAssetUserData(importData);
+	}
+
+	bool createdFontData;
+	URTMSDFFontData* fontData = CastChecked<URTMSDFFontData>(FindOrCreateSiblingAsset(URTMSDFFontData::StaticClass(), texture, texture->GetName() + TEXT("_FontData"), flags, createdFontData));
+	fontData->Atlas = texture;
+	fontData->GlyphSize = (float)importerSettings.GlyphSize;
+	fontData->DistanceRange = (float)atlas.Range;
+	fontData->Ascender = (float)(metrics.ascenderY / metrics.emSize);
+	fontData->Descender = (float)(metrics.descenderY / metrics.emSize);
+	fontData->LineHeight = (float)(metrics.lineHeight / metrics.emSize);
+	fontData->UnderlineY = (float)(metrics.underlineY / metrics.emSize);
+	fontData->UnderlineThickness = (float)(metrics.underlineThickness / metrics.emSize);
+	fontData->Glyphs = MoveTemp(atlas.Glyphs);
+	fontData->Kerning = MoveTemp(atlas.Kerning);
+	fontData->MarkPackageDirty();
+
+	importData->ImportSettings = importerSettings;
+	importData->FontData = fontData;
+
+	texture->bHasBeenPaintedInEditor = false;
+
+	RefReplacer.Replace(texture);
+
+	GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPostImport(this, texture);
+	texture->PostEditChange();
+
+	return texture;
+}
+
+void URTMSDF_FontFactory::ReleaseLoadedFont()
+{
+	RTM::SDF::FontFactoryStatics::LastLoadedFont.Reset();
+}
+
+int32 URTMSDF_FontFactory::GetPriority() const
+{
+	return ImportPriority;
+}
+
+bool URTMSDF_FontFactory::CanReimport(UObject* obj, TArray<FString>& outFilenames)
+{
+	auto* tex = Cast<UTexture2D>(obj);
+	if(tex && !tex->IsA<UCurveLinearColorAtlas>() && tex->GetAssetUserData<URTMSDF_FontImportAssetData>())
+	{
+		tex->AssetImportData->ExtractFilenames(outFilenames);
+		return true;
+	}
+	return false;
+}
+
+void URTMSDF_FontFactory::SetReimportPaths(UObject* obj, const TArray<FString>& newReimportPaths)
+{
+	UTexture* tex = Cast<UTexture2D>(obj);
+	if(tex && ensure(newReimportPaths.Num() == 1))
+		tex->AssetImportData->UpdateFilenameOnly(newReimportPaths[0]);
+}
+
+EReimportResult::Type URTMSDF_FontFactory::Reimport(UObject* obj)
+{
+	auto* texture = Cast<UTexture2D>(obj);
+	if(!ensure(texture))
+		return EReimportResult::Failed;
+
+	const FString textureName = texture->GetName();
+	const FString resolvedSourceFilePath = texture->AssetImportData->GetFirstFilename();
+
+	if(!resolvedSourceFilePath.Len())
+	{
+		UE_LOG(RTMSDFEditor, Error, TEXT("Cannot reimport %s: texture resource does not have path stored."), *textureName);
+		return EReimportResult::Failed;
+	}
+	if(IFileManager::Get().FileSize(*resolvedSourceFilePath) == INDEX_NONE)
+	{
+		UE_LOG(RTMSDFEditor, Warning, TEXT("Cannot reimport %s: source file [%s] cannot be found."), *textureName, *resolvedSourceFilePath);
+		return EReimportResult::Failed;
+	}
+
+	UE_LOG(RTMSDFEditor, Log, TEXT("Performing atomic reimport of %s [%s]"), *textureName, *resolvedSourceFilePath);
+
+	bool outCancelled = false;
+	if(ImportObject(texture->GetClass(), texture->GetOuter(), *textureName, RF_Public | RF_Standalone, resolvedSourceFilePath, nullptr, outCancelled))
+	{
+		if(auto outer = texture->GetOuter())
+			outer->MarkPackageDirty();
+		else
+			texture->MarkPackageDirty();
+
+		texture->AssetImportData->Update(resolvedSourceFilePath);
+
+		return EReimportResult::Succeeded;
+	}
+	else if(outCancelled)
+	{
+		UE_LOG(RTMSDFEditor, Warning, TEXT("import of %s canceled"), *textureName);
+		return EReimportResult::Cancelled;
+	}
+
+	UE_LOG(RTMSDFEditor, Warning, TEXT("import of %s failed"), *textureName);
+	return EReimportResult::Failed;
+}
@@ -0,0 +1,25 @@
+﻿// Copyright (c) Richard Meredith AB. All Rights Reserved
+
+#pragma once
+
+#include "Engine/AssetUserData.h"
+#include "Font/RTMSDFFontData.h"
+#include "RTMSDF_FontImportSettings.h"
+
+#include "RTMSDF_FontImportAssetData.generated.h"
+
+UCLASS(meta=(DisplayName="Font to SDF Import Asset Data [RTMSDF]"))
+class URTMSDF_FontImportAssetData : public UAssetUserData
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, Category="Import", meta=(FullyExpand=true))
+	FRTMSDF_FontImportSettings ImportSettings;
+
+	// Glyph metrics, UVs and kerning of the atlas, kept in an asset of their own next to it
+	UPROPERTY(VisibleAnywhere, Category="Font")
+	TSoftObjectPtr<URTMSDFFontData> FontData;
+
+	virtual bool IsEditorOnly() const override { return true; }
+};
@@ -0,0 +1,77 @@
+﻿// Copyright (c) Richard Meredith AB. All Rights Reserved
+
+#pragma once
+
+#include "Importer/SVG/RTMSDF_SVGImportSettings.h"
+#include "RTMSDF_FontImportSettings.generated.h"
+
+UENUM(meta=(Bitflags, UseEnumValuesAsMaskValuesInEditor="true"))
+enum class ERTMSDFCharacterSet : uint8
+{
+	None = 0 UMETA(Hidden),
+
+	// Printable ASCII
+	BasicLatin = 1 << 0,
+
+	// Latin-1 Supplement and Latin Extended-A and B
+	Latin = 1 << 1,
+
+	Greek = 1 << 2,
+
+	// Cyrillic and Cyrillic Supplement
+	Cyrillic = 1 << 3,
+
+	// CJK punctuation, kana, the CJK Unified Ideographs and fullwidth forms
+	CJK = 1 << 4 UMETA(DisplayName="CJK"),
+};
+
+USTRUCT(meta=(DisplayName="Font to SDF Import Settings [RTMSDF]"))
+struct FRTMSDF_FontImportSettings : public FRTMSDF_CommonImportSettings
+{
+	GENERATED_BODY()
+
+	FRTMSDF_FontImportSettings()
+	{
+		DistanceMode = ERTMSDFDistanceMode::Pixels;
+	}
+
+	UPROPERTY(EditAnywhere, Category="Import")
+	ERTMSDFFormat Format = ERTMSDFFormat::MultichannelPlusAlpha;
+
+	/* Size of one em in the atlas, in texels */
+	UPROPERTY(EditAnywhere, Category="Import", meta=(UIMin=8, ClampMin=1, UIMax=256))
+	int GlyphSize = 48;
+
+	/* Unicode blocks to import. Characters that the font doesn't have are skipped */
+	UPROPERTY(EditAnywhere, Category="Import", meta=(Bitmask, BitmaskEnum="/Script/RTMSDFEditor.ERTMSDFCharacterSet"))
+	uint8 CharacterSets = static_cast<uint8>(ERTMSDFCharacterSet::BasicLatin) | static_cast<uint8>(ERTMSDFCharacterSet::Latin);
+
+	/* Characters to import in addition to the character sets */
+	UPROPERTY(EditAnywhere, Category="Import")
+	FString AdditionalCharacters;
+
+	/* Empty texels between glyphs in the atlas, outside of their distance ranges */
+	UPROPERTY(EditAnywhere, Category="Import", meta=(UIMin=0, ClampMin=0, UIMax=8))
+	int GlyphPadding = 1;
+
+	/* Store kerning between pairs of glyphs outside of the CJK blocks, as far as the font's kern table lists them */
+	UPROPERTY(EditAnywhere, Category="Import")
+	bool ImportKerning = true;
+
+	/* Split intersecting contours and merge overlapping ones before generating, so glyphs can be generated without the slower overlap support */
+	UPROPERTY(EditAnywhere, Category="Import")
+	bool ResolveGeometry = true;
+
+	UPROPERTY(EditAnywhere, Category="Import", meta=(EditCondition="Format == ERTMSDFFormat::Multichannel || Format == ERTMSDFFormat::MultichannelPlusAlpha", DisplayAfter="InvertDistance"))
+	ERTMSDFColoringMode EdgeColoringMode = ERTMSDFColoringMode::InkTrap;
+
+	UPROPERTY(EditAnywhere, Category="Import", meta=(EditCondition="Format == ERTMSDFFormat::Multichannel || Format == ERTMSDFFormat::MultichannelPlusAlpha", DisplayAfter="InvertDistance"))
+	int EdgeColoringSeed = 0;
+
+	/* Maximum angle to treat a corner as a corner for the sake of edge coloring / preserving sharpness*/
+	UPROPERTY(EditAnywhere, Category="Import", meta=(EditCondition="Format == ERTMSDFFormat::Multichannel || Format == ERTMSDFFormat::MultichannelPlusAlpha", DisplayAfter="InvertDistance", UIMin=1, ClampMin=1, UIMax=179, ClampMax=179))
+	float MaxCornerAngle = 175.0f;
+
+	UPROPERTY(EditAnywhere, Category="Import", meta=(EditCondition="Format == ERTMSDFFormat::Multichannel || Format == ERTMSDFFormat::MultichannelPlusAlpha", DisplayAfter="InvertDistance"))
+	ERTMSDFErrorCorrectionMode ErrorCorrectionMode = ERTMSDFErrorCorrectionMode::EdgePriorityFull;
+};
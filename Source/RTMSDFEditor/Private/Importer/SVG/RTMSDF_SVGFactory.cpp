@@ -1,8 +1,10 @@
 ﻿// Copyright (c) Richard Meredith AB. All Rights Reserved
 
 #include "AssetImportTask.h"
+#include "Async/ParallelFor.h"
 #include "ChlumskyMSDFGen/Public/Core/msdfgen.h"
 #include "ChlumskyMSDFGen/Public/Ext/import-svg.h"
+#include "ChlumskyMSDFGen/Public/Ext/resolve-shape-geometry.h"
 #include "Config/RTMSDFConfig.h"
 #include "Curves/CurveLinearColorAtlas.h"
 #include "Editor.h"
@@ -10,6 +12,7 @@
 #include "Engine/Texture2DArray.h"
 #include "Importer/RTMSDFTextureSettingsCache.h"
 #include "Module/RTMSDFEditor.h"
+#include "ObjectTools.h"
 #include "RTMSDF_SVGFactory.h"
 #include "RTMSDF_SVGGenerationHelpers.h"
 #include "RTMSDF_SVGImportAssetData.h"
@@ -20,6 +23,167 @@
 #include "TextureReferenceResolver.h"
 #endif
 
+namespace RTM::SDF::SVGFactoryStatics
+{
+	using namespace msdfgen;
+	using namespace RTMSDFGenerationHelpers;
+
+	template<typename T>
+	T* FindOrCreateSpriteAsset(const UObject* atlas, const FString& name, EObjectFlags flags, bool& outCreated)
+	{
+		return CastChecked<T>(FindOrCreateSiblingAsset(T::StaticClass(), atlas, name, flags, outCreated));
+	}
+
+	// Generates every sprite into a square cell of the atlas, and into textures and a texture array of their own if the sprite sheet mode asks for them
+	void GenerateSpriteSheet(std::vector<SvgSprite>& sprites, const FRTMSDF_SVGImportSettings& settings, const FRTMSDFTextureSettingsCache& textureSettings, UTexture2D* atlas, EObjectFlags flags, TArray<FRTMSDF_SVGSprite>& outSprites, TSoftObjectPtr<UTexture2DArray>& outSpriteArray)
+	{
+		const int32 spriteCount = (int32)sprites.size();
+		const int32 cellSize = FMath::Max(settings.TextureSize, 1);
+		const bool multichannel = settings.Format == ERTMSDFFormat::Multichannel || settings.Format == ERTMSDFFormat::MultichannelPlusAlpha;
+		const double angleThreshold = FMath::DegreesToRadians(settings.MaxCornerAngle);
+
+		TArray<MSDFGeneratorConfig> generatorConfigs;
+		TArray<Projection> projections;
+		TArray<FRTMSDFGenerationJob> jobs;
+		TArray<TArray<uint8>> pixels;
+		generatorConfigs.SetNum(spriteCount);
+		projections.SetNum(spriteCount);
+		jobs.SetNum(spriteCount);
+		pixels.SetNum(spriteCount);
+
+		// Shapes are prepared in parallel, and then generated as a single batch so small sprites don't leave workers idle
+		FThreadSafeCounter unresolvedShapes;
+		ParallelFor(spriteCount, [&](int32 i)
+		{
+			SvgSprite& sprite = sprites[i];
+			Vector2 spriteDims = sprite.dimensions;
+			double scale = cellSize / max(spriteDims.x, spriteDims.y);
+			double range = GetDistanceRange(settings, spriteDims, scale);
+
+			// Groups are cropped to their geometry, so they are given a margin of the distance range around it. The margin shrinks the scale, so the
+			// two are solved for together - a range in pixels takes up that many texels of the cell, any other range as many units of the sprite
+			Vector2 offset;
+			if(!sprite.viewBox)
+			{
+				const double geometrySize = max(spriteDims.x, spriteDims.y);
+				if(settings.DistanceMode == ERTMSDFDistanceMode::Pixels)
+					scale = FMath::Max(cellSize - 2.0 * settings.PixelDistance, 1.0) / geometrySize;
+				else
+					scale = cellSize / (geometrySize + 2.0 * range);
+				range = GetDistanceRange(settings, spriteDims, scale);
+				offset = Vector2(range);
+				spriteDims += 2.0 * offset;
+			}
+			offset += 0.5 * (Vector2(cellSize / scale) - spriteDims);
+			projections[i] = Projection(Vector2(scale), offset);
+
+			const bool resolvedGeometry = settings.ResolveGeometry && resolveShapeGeometry(sprite.shape);
+			if(!resolvedGeometry)
+			{
+				if(settings.ResolveGeometry)
+					unresolvedShapes.Increment();
+				sprite.shape.orientContours();
+			}
+
+			generatorConfigs[i].overlapSupport = !resolvedGeometry;
+			ApplyErrorCorrectionModeTo(generatorConfigs[i].errorCorrection, settings.ErrorCorrectionMode);
+			if(multichannel)
+				DoEdgeColoring(sprite.shape, settings.EdgeColoringMode, angleThreshold, settings.EdgeColoringSeed);
+
+			FRTMSDFGenerationJob& job = jobs[i];
+			job.Format = settings.Format;
+			job.GeneratorConfig = &generatorConfigs[i];
+			job.Shape = SharedShape(MoveTemp(sprite.shape));
+			job.Projection = &projections[i];
+			job.Width = cellSize;
+			job.Height = cellSize;
+			job.Range = range;
+			job.InvertDistance = settings.InvertDistance;
+			job.OutPixels = &pixels[i];
+		});
+
+		if(unresolvedShapes.GetValue() > 0)
+			UE_LOG(RTMSDFEditor, Log, TEXT("Unable to resolve overlapping geometry of %d sprites of %s - falling back to overlap support"), unresolvedShapes.GetValue(), *atlas->GetName());
+
+		GenerateBatch(jobs);
+
+		// Cells are laid out in rows of a roughly square grid, and unused cells are left outside of any shape
+		const int32 columns = FMath::CeilToInt(FMath::Sqrt((float)spriteCount));
+		const int32 rows = FMath::DivideAndRoundUp(spriteCount, columns);
+		const int32 atlasWidth = columns * cellSize;
+		const int32 atlasHeight = rows * cellSize;
+		const int32 texelSize = multichannel ? 4 : 1;
+		const ETextureSourceFormat sourceFormat = multichannel ? TSF_BGRA8 : TSF_G8;
+
+		TArray<uint8> atlasPixels;
+		atlasPixels.Init(settings.InvertDistance ? 255 : 0, atlasWidth * atlasHeight * texelSize);
+		if(settings.Format == ERTMSDFFormat::Multichannel)
+		{
+			for(int32 i = 3; i < atlasPixels.Num(); i += 4)
+				atlasPixels[i] = 255;
+		}
+
+		outSprites.SetNum(spriteCount);
+		ParallelFor(spriteCount, [&](int32 i)
+		{
+			const int32 x = (i % columns) * cellSize;
+			const int32 y = (i / columns) * cellSize;
+			if(pixels[i].Num() == cellSize * cellSize * texelSize)
+			{
+				for(int32 row = 0; row < cellSize; row++)
+					FMemory::Memcpy(&atlasPixels[((y + row) * atlasWidth + x) * texelSize], &pixels[i][row * cellSize * texelSize], cellSize * texelSize);
+			}
+
+			outSprites[i].Id = UTF8_TO_TCHAR(sprites[i].id.c_str());
+			outSprites[i].UVs = FBox2D(FVector2D((double)x / atlasWidth, (double)y / atlasHeight), FVector2D((double)(x + cellSize) / atlasWidth, (double)(y + cellSize) / atlasHeight));
+		});
+		atlas->Source.Init(atlasWidth, atlasHeight, 1, 1, sourceFormat, atlasPixels.GetData());
+
+		if(settings.SpriteSheetMode != ERTMSDFSpriteSheetMode::Textures && settings.SpriteSheetMode != ERTMSDFSpriteSheetMode::TextureArray)
+			return;
+
+		TSet<FString> textureNames;
+		TArray<UTexture2D*> spriteTextures;
+		for(int32 i = 0; i < spriteCount; i++)
+		{
+			// Ids that only differ in characters that asset names can't hold would otherwise share a texture
+			const FString baseName = atlas->GetName() + TEXT("_") + ObjectTools::SanitizeObjectName(outSprites[i].Id);
+			FString name = baseName;
+			for(int32 suffix = 2; textureNames.Contains(name); suffix++)
+				name = FString::Printf(TEXT("%s_%d"), *baseName, suffix);
+			textureNames.Add(name);
+
+			bool created;
+			UTexture2D* spriteTexture = FindOrCreateSpriteAsset<UTexture2D>(atlas, name, flags, created);
+			const FRTMSDFTextureSettingsCache spriteTextureSettings = created ? textureSettings : FRTMSDFTextureSettingsCache(spriteTexture);
+			spriteTexture->PreEditChange(nullptr);
+			spriteTexture->Source.Init(cellSize, cellSize, 1, 1, sourceFormat, pixels[i].GetData());
+			UpdateNewTextureSettings(spriteTexture, spriteTextureSettings, settings.Format);
+			spriteTexture->PostEditChange();
+			spriteTexture->MarkPackageDirty();
+
+			outSprites[i].Texture = spriteTexture;
+			spriteTextures.Add(spriteTexture);
+		}
+
+		if(settings.SpriteSheetMode != ERTMSDFSpriteSheetMode::TextureArray || spriteTextures.Num() == 0)
+			return;
+
+		bool created;
+		UTexture2DArray* spriteArray = FindOrCreateSpriteAsset<UTexture2DArray>(atlas, atlas->GetName() + TEXT("_Array"), flags, created);
+		spriteArray->PreEditChange(nullptr);
+		spriteArray->SourceTextures.Reset();
+		for(UTexture2D* spriteTexture : spriteTextures)
+			spriteArray->SourceTextures.Add(spriteTexture);
+		spriteArray->SRGB = false;
+		spriteArray->CompressionSettings = spriteTextures[0]->CompressionSettings;
+		spriteArray->UpdateSourceFromSourceTextures(created);
+		spriteArray->PostEditChange();
+		spriteArray->MarkPackageDirty();
+		outSpriteArray = spriteArray;
+	}
+}
+
 URTMSDF_SVGFactory::URTMSDF_SVGFactory()
 {
 	bCreateNew = false;
@@ -49,6 +213,7 @@ UObject* URTMSDF_SVGFactory::FactoryCreateBinary(UClass* inClass, UObject* inPar
 {
 	using namespace msdfgen;
 	using namespace RTMSDFGenerationHelpers;
+	using namespace RTM::SDF::SVGFactoryStatics;
 
 	GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPreImport(this, inClass, inParent, inName, type);
 
@@ -69,9 +234,11 @@ UObject* URTMSDF_SVGFactory::FactoryCreateBinary(UClass* inClass, UObject* inPar
 	FTextureReferenceReplacer RefReplacer(existingTexture);
 	FRTMSDFTextureSettingsCache textureSettings(existingTexture);
 	FRTMSDF_SVGImportSettings importerSettings;
+	FRTMSDFEdgeColoringCache edgeColoringCache;
 	if(const auto* previousSettings = existingTexture ? existingTexture->GetAssetUserData<URTMSDF_SVGImportAssetData>() : nullptr)
 	{
 		importerSettings = previousSettings->ImportSettings;
+		edgeColoringCache = previousSettings->EdgeColoringCache;
 	}
 	else if(const auto* defaultConfig = GetDefault<URTMSDFConfig>())
 	{
@@ -81,14 +248,38 @@ UObject* URTMSDF_SVGFactory::FactoryCreateBinary(UClass* inClass, UObject* inPar
 
 	Shape shape;
 	Vector2 svgDims;
-	if(!CreateShape(buffer, bufferEnd, shape, svgDims))
+	std::vector<SvgSprite> sprites;
+	const bool spriteSheet = importerSettings.SpriteSheetMode != ERTMSDFSpriteSheetMode::Disabled;
+	const bool cacheShapes = !spriteSheet && GetDefault<URTMSDFConfig>()->CacheParsedShapes;
+	// Arc tolerance is set in texels, and the texture's shortest edge spans the SVG's smaller dimension
+	const double arcTolerance = importerSettings.ArcTolerance / FMath::Max(importerSettings.TextureSize, 1);
+	const uint64 shapeSourceHash = cacheShapes ? HashShapeSource(buffer, bufferEnd, arcTolerance, importerSettings.ResolveGeometry) : 0;
+	if(spriteSheet)
+	{
+		if(!CreateSpriteShapes(buffer, bufferEnd, arcTolerance, importerSettings.ResolveGeometry, sprites, inName.ToString()))
+		{
+			UE_LOG(RTMSDFEditor, Error, TEXT("Import for %s failed - no sprites found in the sprite sheet"), *inName.ToString());
+			GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPostImport(this, nullptr);
+			return nullptr;
+		}
+	}
+	else if(cacheShapes && LoadCachedShape(shapeSourceHash, shape, svgDims))
+	{
+		UE_LOG(RTMSDFEditor, Log, TEXT("Reused cached shape for %s"), *inName.ToString());
+	}
+	else if(CreateShape(buffer, bufferEnd, arcTolerance, importerSettings.ResolveGeometry, shape, svgDims, inName.ToString()))
+	{
+		if(cacheShapes)
+			SaveCachedShape(shapeSourceHash, shape, svgDims, (int64)GetDefault<URTMSDFConfig>()->ShapeCacheSizeLimitMB << 20);
+	}
+	else
 	{
 		UE_LOG(RTMSDFEditor, Error, TEXT("Import for %s failed - unable to create Shape"), *inName.ToString());
 		GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPostImport(this, nullptr);
 		return nullptr;
 	}
 
-	shape.normalize();
+	// CreateShape has already normalized the shape - a second pass would only deconverge corners again
 	// TODO VAlidate shape: shape.validate()
 	// 	shape.validate();
 
@@ -109,30 +300,50 @@ UObject* URTMSDF_SVGFactory::FactoryCreateBinary(UClass* inClass, UObject* inPar
 		return nullptr;
 	}
 
-	Vector2 scale = (double)(importerSettings.TextureSize) / min(svgDims.x, svgDims.y);
-	Vector2 msdfDims = svgDims * scale;
-	Projection projection(scale, 0.0f);
+	// The edge coloring search and cache only cover whole documents - sprites are colored with the configured mode and seed
+	TArray<FRTMSDF_SVGSprite> spriteRecords;
+	TSoftObjectPtr<UTexture2DArray> spriteArray;
+	if(spriteSheet)
+	{
+		GenerateSpriteSheet(sprites, importerSettings, textureSettings, texture, flags, spriteRecords, spriteArray);
+		edgeColoringCache = FRTMSDFEdgeColoringCache();
+	}
+	else
+	{
+		Vector2 scale = (double)(importerSettings.TextureSize) / min(svgDims.x, svgDims.y);
+		Vector2 msdfDims = svgDims * scale;
+		Projection projection(scale, 0.0f);
 
-#ifdef MSDFGEN_USE_SKIA
-	// TODO: SKIA : resolve shape goes here
-	static_assert(false, "Skia not implemented, but building with 'MSDFGEN_USE_SKIA")
-#else
-	shape.orientContours();
-#endif
+		// Resolved shapes have no overlapping contours left, so they don't need the (much slower) overlap combiner
+		const bool resolvedGeometry = importerSettings.ResolveGeometry && resolveShapeGeometry(shape);
+		if(!resolvedGeometry)
+		{
+			// Open paths are valid SVG (they're filled as if closed) but can't be resolved, so this is expected and only logged
+			if(importerSettings.ResolveGeometry)
+				UE_LOG(RTMSDFEditor, Log, TEXT("Unable to resolve overlapping geometry of %s - falling back to overlap support"), *inName.ToString());
+			shape.orientContours();
+		}
 
-	double range = importerSettings.AbsoluteDistance;
-	if(importerSettings.DistanceMode == ERTMSDFDistanceMode::Normalized)
-		range = importerSettings.NormalizedDistance * min(svgDims.x, svgDims.y);
-	else if(importerSettings.DistanceMode == ERTMSDFDistanceMode::Pixels)
-		range = importerSettings.PixelDistance / min(scale.x, scale.y);
+		const double range = GetDistanceRange(importerSettings, svgDims, min(scale.x, scale.y));
 
-	if(importerSettings.Format == ERTMSDFFormat::Multichannel || importerSettings.Format == ERTMSDFFormat::MultichannelPlusAlpha)
-		DoEdgeColoring(shape, importerSettings.EdgeColoringMode, FMath::DegreesToRadians(importerSettings.MaxCornerAngle), importerSettings.EdgeColoringSeed);
+		MSDFGeneratorConfig generatorConfig;
+		generatorConfig.overlapSupport = !resolvedGeometry;
+		ApplyErrorCorrectionModeTo(generatorConfig.errorCorrection, importerSettings.ErrorCorrectionMode);
 
-	MSDFGeneratorConfig generatorConfig;
-	generatorConfig.overlapSupport = true;
-	ApplyErrorCorrectionModeTo(generatorConfig.errorCorrection, importerSettings.ErrorCorrectionMode);
-	Generate(importerSettings.Format, generatorConfig, msdfDims, shape, projection, range, importerSettings.InvertDistance, texture);
+		if(importerSettings.Format == ERTMSDFFormat::Multichannel || importerSettings.Format == ERTMSDFFormat::MultichannelPlusAlpha)
+		{
+			// The winner is stored in the import settings below, so later reimports start their search from it
+			if(importerSettings.EdgeColoringCandidates > 1)
+			{
+				const FRTMSDFEdgeColoringCandidate best = FindBestEdgeColoring(shape, svgDims, importerSettings, generatorConfig, range);
+				importerSettings.EdgeColoringMode = best.Mode;
+				importerSettings.EdgeColoringSeed = (int)best.Seed;
+			}
+			if(DoEdgeColoring(shape, importerSettings.EdgeColoringMode, FMath::DegreesToRadians(importerSettings.MaxCornerAngle), importerSettings.EdgeColoringSeed, edgeColoringCache))
+				UE_LOG(RTMSDFEditor, Log, TEXT("Reused edge coloring from previous import of %s"), *inName.ToString());
+		}
+		Generate(importerSettings.Format, generatorConfig, msdfDims, SharedShape(MoveTemp(shape)), projection, range, importerSettings.InvertDistance, texture);
+	}
 
 	if(!existingTexture)
 	{
@@ -143,13 +354,19 @@ UObject* URTMSDF_SVGFactory::FactoryCreateBinary(UClass* inClass, UObject* inPar
 
 	texture->AssetImportData->Update(CurrentFilename, FileHash.IsValid() ? &FileHash : nullptr);
 
-	if(!texture->GetAssetUserData<URTMSDF_SVGImportAssetData>())
+	auto importData = texture->GetAssetUserData<URTMSDF_SVGImportAssetData>();
+	if(!importData)
 	{
-		auto importData = NewObject<URTMSDF_SVGImportAssetData>(texture, NAME_None, flags);
-		importData->ImportSettings = importerSettings;
+		importData = NewObject<URTMSDF_SVGImportAssetData>(texture, NAME_None, flags);
 		texture->AddAssetUserData(importData);
 	}
 
+	// Settings only differ from the stored ones if an edge coloring search picked a new seed
+	importData->ImportSettings = importerSettings;
+	importData->EdgeColoringCache = MoveTemp(edgeColoringCache);
+	importData->Sprites = MoveTemp(spriteRecords);
+	importData->SpriteArray = spriteArray;
+
 	texture->bHasBeenPaintedInEditor = false;
 
 	RefReplacer.Replace(texture);
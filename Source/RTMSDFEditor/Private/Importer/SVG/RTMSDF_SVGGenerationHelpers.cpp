@@ -2,35 +2,261 @@
 
 #include "RTMSDF_SVGGenerationHelpers.h"
 #include "Importer/RTMSDFTextureSettingsCache.h"
+#include "RTMSDF_SVGImportAssetData.h"
 #include "RTMSDF_SVGImportSettings.h"
 #include "Module/RTMSDFEditor.h"
 #include "ChlumskyMSDFGen/Public/Core/msdfgen.h"
+#include "ChlumskyMSDFGen/Public/Core/sdf-error-estimation.h"
+#include "ChlumskyMSDFGen/Public/Core/shape-binary.h"
 #include "ChlumskyMSDFGen/Public/Ext/import-svg.h"
+#include "ChlumskyMSDFGen/Public/Ext/resolve-shape-geometry.h"
+#include "Async/MappedFileHandle.h"
+#include "Async/ParallelFor.h"
 #include "Engine/Texture2DArray.h"
+#include "HAL/PlatformFileManager.h"
+#include "Hash/CityHash.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+
+#if ENGINE_MAJOR_VERSION >=5
+#include "AssetRegistry/AssetRegistryModule.h"
+#else
+#include "AssetRegistryModule.h"
+#endif
 
 namespace RTMSDFGenerationHelpers
 {
 	using namespace msdfgen;
 
-	bool CreateShape(const uint8* buffer, const uint8* bufferEnd, Shape& outShape, Vector2& outSvgDims)
+	// Weight of the portion of preview texels flattened by error correction, relative to the estimated portion of incorrectly filled area
+	constexpr double CorrectedTexelPenalty = 0.25;
+	constexpr int32 EdgeColoringScanlinesPerRow = 4;
+
+	// Bump whenever the edge coloring algorithms change their output, to invalidate cached colors
+	constexpr uint64 EdgeColoringCacheVersion = 2;
+
+	// Bump whenever CreateShape produces different shapes from the same SVG, to invalidate cached shapes
+	constexpr uint64 ShapeCacheVersion = 6;
+
+	// Cached shape files hold the SVG dimensions followed by the shape in the msdfgen binary shape format
+	struct FRTMSDFShapeCacheHeader
+	{
+		double SvgWidth;
+		double SvgHeight;
+	};
+
+	FString GetShapeCacheDir()
 	{
-		size_t bufferLen = bufferEnd - buffer + 1;
-		char* input = new char[bufferLen];
-		for(int i = 0; i < bufferLen; i++)
-			input[i] = static_cast<char>(buffer[i]);		// TODO - memcpy here;
+		return FPaths::ProjectSavedDir() / TEXT("RTMSDF");
+	}
+
+	FString GetCachedShapePath(uint64 sourceHash)
+	{
+		return GetShapeCacheDir() / FString::Printf(TEXT("%016llx.msdfshape"), sourceHash);
+	}
+
+	// Deletes the least recently used cached shapes until the rest fit in the size limit.
+	// Every edit of an SVG leaves a file under a new hash behind, so without this the cache only ever grows
+	void TrimShapeCache(int64 sizeLimit)
+	{
+		struct FCachedShapeFile
+		{
+			FString Path;
+			FDateTime Used;
+			int64 Size;
+		};
+
+		TArray<FCachedShapeFile> files;
+		int64 totalSize = 0;
+		IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+		platformFile.IterateDirectoryStat(*GetShapeCacheDir(), [&](const TCHAR* path, const FFileStatData& stat)
+		{
+			if(!stat.bIsDirectory && FPaths::GetExtension(path) == TEXT("msdfshape"))
+			{
+				files.Add({path, stat.ModificationTime, stat.FileSize});
+				totalSize += stat.FileSize;
+			}
+			return true;
+		});
+		if(totalSize <= sizeLimit)
+			return;
+
+		files.Sort([](const FCachedShapeFile& a, const FCachedShapeFile& b) { return a.Used < b.Used; });
+		for(const FCachedShapeFile& file : files)
+		{
+			if(totalSize <= sizeLimit)
+				break;
+			if(platformFile.DeleteFile(*file.Path))
+				totalSize -= file.Size;
+		}
+	}
+
+	bool ReadCachedShape(const uint8* data, int64 size, Shape& outShape, Vector2& outSvgDims)
+	{
+		if(size < (int64)sizeof(FRTMSDFShapeCacheHeader))
+			return false;
+
+		FRTMSDFShapeCacheHeader header;
+		FMemory::Memcpy(&header, data, sizeof(header));
+		if(!readShapeBinary(data + sizeof(header), size - sizeof(header), outShape))
+			return false;
+
+		outSvgDims = Vector2(header.SvgWidth, header.SvgHeight);
+		return true;
+	}
+
+	void LogPlacedEdgeLimit(const FString& sourceName, const SvgImportStats& stats)
+	{
+		if(stats.placedEdgeLimitExceeded)
+			UE_LOG(RTMSDFEditor, Error, TEXT("%s has too many <use> instances - the geometry they place exceeds the importer's edge limit"), *sourceName);
+	}
+
+	void LogDroppedGeometry(const FString& sourceName, const SvgImportStats& stats, int32 removedContours, int32 removedEdges)
+	{
+		if(stats.hiddenElements || stats.emptyElements || removedContours)
+		{
+			UE_LOG(RTMSDFEditor, Log, TEXT("Dropped geometry of %s - %d hidden elements, %d empty elements, %d zero area contours (%d edges)"),
+				*sourceName, stats.hiddenElements, stats.emptyElements, removedContours, removedEdges);
+		}
+	}
+
+	// Returns the number of edges removed, and adds the number of contours removed to removedContours
+	int32 NormalizeShape(Shape& shape, int32& removedContours)
+	{
+		// Zero area contours are only found reliably once normalize has split single edge contours
+		shape.normalize();
+		const int32 contourCount = (int32)shape.contours.size();
+		const int32 removedEdges = shape.removeZeroAreaContours();
+		removedContours += contourCount - (int32)shape.contours.size();
+		shape.inverseYAxis = !shape.inverseYAxis;
+		return removedEdges;
+	}
+
+	// Returns false if the outline has no contours left to generate. Outlines that aren't resolved have their contours oriented instead
+	bool PrepareGlyphOutline(Shape& outline, bool resolveGeometry, bool& outResolvedGeometry)
+	{
+		outline.normalize();
+		outline.removeZeroAreaContours();
+		if(outline.contours.empty())
+			return false;
+
+		outResolvedGeometry = resolveGeometry && resolveShapeGeometry(outline);
+		if(!outResolvedGeometry)
+			outline.orientContours();
+		return true;
+	}
 
-		bool builtShape = buildShapeFromSvgFileBuffer(outShape, input, bufferLen, 0, &outSvgDims);
-		delete(input);
+	// arcTolerance is relative to the smaller of the SVG dimensions. resolveElements has each element's geometry resolved on its own as it is parsed
+	bool CreateShape(const uint8* buffer, const uint8* bufferEnd, double arcTolerance, bool resolveElements, Shape& outShape, Vector2& outSvgDims, const FString& sourceName)
+	{
+		// The parser reads the factory's buffer in place, so no copy of the file is made
+		SvgImportStats stats;
+		const bool builtShape = buildShapeFromSvgFileBuffer(outShape, reinterpret_cast<const char*>(buffer), bufferEnd - buffer, 0, &outSvgDims, arcTolerance, &stats, resolveElements);
 
 		if(builtShape)
 		{
-			outShape.normalize();
-			outShape.inverseYAxis = !outShape.inverseYAxis;
+			int32 removedContours = 0;
+			const int32 removedEdges = NormalizeShape(outShape, removedContours);
+			LogDroppedGeometry(sourceName, stats, removedContours, removedEdges);
+		}
+		else
+		{
+			LogPlacedEdgeLimit(sourceName, stats);
 		}
 
 		return builtShape;
 	}
 
+	// arcTolerance is relative to the smaller of each symbol's viewBox dimensions
+	bool CreateSpriteShapes(const uint8* buffer, const uint8* bufferEnd, double arcTolerance, bool resolveElements, std::vector<SvgSprite>& outSprites, const FString& sourceName)
+	{
+		SvgImportStats stats;
+		if(!buildShapesFromSvgSpriteSheet(outSprites, reinterpret_cast<const char*>(buffer), bufferEnd - buffer, arcTolerance, &stats, resolveElements))
+		{
+			LogPlacedEdgeLimit(sourceName, stats);
+			return false;
+		}
+
+		TArray<int32> removedContours, removedEdges;
+		removedContours.SetNumZeroed(outSprites.size());
+		removedEdges.SetNumZeroed(outSprites.size());
+		ParallelFor((int32)outSprites.size(), [&](int32 i)
+		{
+			removedEdges[i] = NormalizeShape(outSprites[i].shape, removedContours[i]);
+		});
+
+		int32 totalContours = 0, totalEdges = 0;
+		for(int32 i = 0; i < removedContours.Num(); ++i)
+		{
+			totalContours += removedContours[i];
+			totalEdges += removedEdges[i];
+		}
+		LogDroppedGeometry(sourceName, stats, totalContours, totalEdges);
+		return true;
+	}
+
+	// scale maps units of the source (the SVG document or font) to texels
+	double GetDistanceRange(const FRTMSDF_CommonImportSettings& settings, const Vector2& sourceDims, double scale)
+	{
+		switch(settings.DistanceMode)
+		{
+			case ERTMSDFDistanceMode::Normalized:
+				return settings.NormalizedDistance * min(sourceDims.x, sourceDims.y);
+			case ERTMSDFDistanceMode::Pixels:
+				return settings.PixelDistance / scale;
+			default:
+				return settings.AbsoluteDistance;
+		}
+	}
+
+	uint64 HashShapeSource(const uint8* buffer, const uint8* bufferEnd, double arcTolerance, bool resolveElements)
+	{
+		// The arc tolerance and resolving elements change the parsed shape, so they are hashed along with the source - the latter in the low bit of the version seed
+		uint64 arcToleranceBits;
+		FMemory::Memcpy(&arcToleranceBits, &arcTolerance, sizeof(arcToleranceBits));
+		return CityHash64WithSeeds(reinterpret_cast<const char*>(buffer), bufferEnd - buffer, ShapeCacheVersion << 1 | (resolveElements ? 1 : 0), arcToleranceBits);
+	}
+
+	bool LoadCachedShape(uint64 sourceHash, Shape& outShape, Vector2& outSvgDims)
+	{
+		const FString path = GetCachedShapePath(sourceHash);
+
+		// Read the shape straight out of the mapped file where the platform supports it
+		IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+		if(platformFile.FileExists(*path))
+		{
+			// The modification time doubles as the last use, which TrimShapeCache evicts by
+			platformFile.SetTimeStamp(*path, FDateTime::UtcNow());
+			TUniquePtr<IMappedFileHandle> mappedFile(platformFile.OpenMapped(*path));
+			TUniquePtr<IMappedFileRegion> mappedRegion(mappedFile ? mappedFile->MapRegion() : nullptr);
+			if(mappedRegion)
+				return ReadCachedShape(mappedRegion->GetMappedPtr(), mappedRegion->GetMappedSize(), outShape, outSvgDims);
+		}
+
+		TArray64<uint8> data;
+		if(!FFileHelper::LoadFileToArray(data, *path, FILEREAD_Silent))
+			return false;
+
+		return ReadCachedShape(data.GetData(), data.Num(), outShape, outSvgDims);
+	}
+
+	void SaveCachedShape(uint64 sourceHash, const Shape& shape, const Vector2& svgDims, int64 cacheSizeLimit)
+	{
+		const FRTMSDFShapeCacheHeader header = { svgDims.x, svgDims.y };
+		const size_t shapeSize = shapeBinarySize(shape);
+
+		TArray<uint8> data;
+		data.SetNumUninitialized(sizeof(header) + shapeSize);
+		FMemory::Memcpy(data.GetData(), &header, sizeof(header));
+		writeShapeBinary(data.GetData() + sizeof(header), shapeSize, shape);
+
+		if(!FFileHelper::SaveArrayToFile(data, *GetCachedShapePath(sourceHash)))
+			UE_LOG(RTMSDFEditor, Warning, TEXT("Unable to write shape cache file %s"), *GetCachedShapePath(sourceHash));
+
+		TrimShapeCache(cacheSizeLimit);
+	}
+
 	void DoEdgeColoring(Shape& shape, ERTMSDFColoringMode mode, double angleThreshold, int64 seed)
 	{
 		switch(mode)
@@ -49,6 +275,85 @@ namespace RTMSDFGenerationHelpers
 		}
 	}
 
+	bool DoEdgeColoring(Shape& shape, ERTMSDFColoringMode mode, double angleThreshold, int64 seed, FRTMSDFEdgeColoringCache& cache)
+	{
+		const uint64 hash = HashEdgeColoringInputs(shape, mode, angleThreshold, seed);
+		const int32 edgeCount = shape.edgeCount();
+		if(hash == cache.Hash && cache.EdgeColors.Num() == edgeCount)
+		{
+			int32 i = 0;
+			for(Contour& contour : shape.contours)
+			{
+				for(EdgeHolder& edge : contour.edges)
+					edge->color = static_cast<EdgeColor>(cache.EdgeColors[i++]);
+			}
+			return true;
+		}
+
+		DoEdgeColoring(shape, mode, angleThreshold, seed);
+
+		// Colorings that split edges can't be replayed onto the unsplit shape, so leave them uncached
+		cache.Hash = hash;
+		cache.EdgeColors.Reset();
+		if(shape.edgeCount() == edgeCount)
+		{
+			cache.EdgeColors.Reserve(edgeCount);
+			for(const Contour& contour : shape.contours)
+			{
+				for(const EdgeHolder& edge : contour.edges)
+					cache.EdgeColors.Add(static_cast<uint8>(edge->color));
+			}
+		}
+		return false;
+	}
+
+	uint64 HashEdgeColoringInputs(const Shape& shape, ERTMSDFColoringMode mode, double angleThreshold, int64 seed)
+	{
+		// Integer inputs and coordinates are hashed as separate arrays, so 64-bit seeds keep all of their bits
+		TArray<uint64> layout;
+		TArray<double> coordinates;
+		layout.Reserve(shape.edgeCount() + shape.contours.size() + 3);
+		coordinates.Reserve(shape.edgeCount() * 8 + 1);
+		layout.Add(EdgeColoringCacheVersion);
+		layout.Add(static_cast<uint64>(mode));
+		layout.Add(static_cast<uint64>(seed));
+		coordinates.Add(angleThreshold);
+		for(const Contour& contour : shape.contours)
+		{
+			layout.Add(static_cast<uint64>(contour.edges.size()));
+			for(const EdgeHolder& edge : contour.edges)
+			{
+				const Point2* points = nullptr;
+				int32 pointCount = 0;
+				switch(edge->type)
+				{
+					case EdgeSegment::SegmentType::Linear:
+						points = static_cast<const LinearSegment*>(&*edge)->p;
+						pointCount = 2;
+						break;
+					case EdgeSegment::SegmentType::Quadratic:
+						points = static_cast<const QuadraticSegment*>(&*edge)->p;
+						pointCount = 3;
+						break;
+					case EdgeSegment::SegmentType::Cubic:
+						points = static_cast<const CubicSegment*>(&*edge)->p;
+						pointCount = 4;
+						break;
+					default:
+						break;
+				}
+				layout.Add(static_cast<uint64>(edge->type));
+				for(int32 i = 0; i < pointCount; i++)
+				{
+					coordinates.Add(points[i].x);
+					coordinates.Add(points[i].y);
+				}
+			}
+		}
+		const uint64 layoutHash = CityHash64(reinterpret_cast<const char*>(layout.GetData()), layout.Num() * sizeof(uint64));
+		return CityHash64WithSeed(reinterpret_cast<const char*>(coordinates.GetData()), coordinates.Num() * sizeof(double), layoutHash);
+	}
+
 	void ApplyErrorCorrectionModeTo(ErrorCorrectionConfig& config, ERTMSDFErrorCorrectionMode mode)
 	{
 		switch(mode)
@@ -90,60 +395,228 @@ namespace RTMSDFGenerationHelpers
 		}
 	}
 
-	void Generate(ERTMSDFFormat format, const MSDFGeneratorConfig& generatorConfig, const Vector2& msdfDims, const Shape& shape, const Projection& projection, double range, bool invertDistance, UTexture2D* outTexture)
+	FRTMSDFEdgeColoringCandidate FindBestEdgeColoring(const Shape& shape, const Vector2& svgDims, const FRTMSDF_SVGImportSettings& settings, const MSDFGeneratorConfig& generatorConfig, double range)
 	{
-		switch(format)
+		const double startTime = FPlatformTime::Seconds();
+
+		// The current seed and mode always come first, so that ties keep the existing coloring
+		TArray<FRTMSDFEdgeColoringCandidate> candidates;
+		for(int32 i = 0; i < FMath::Max(1, settings.EdgeColoringCandidates); i++)
 		{
-			case ERTMSDFFormat::SingleChannel:
+			candidates.Add({settings.EdgeColoringMode, (int64)settings.EdgeColoringSeed + i});
+			if(settings.SearchEdgeColoringModes)
+			{
+				for(ERTMSDFColoringMode mode : {ERTMSDFColoringMode::Simple, ERTMSDFColoringMode::InkTrap, ERTMSDFColoringMode::Distance})
 				{
-					Bitmap<float, 1> sdf(msdfDims.x, msdfDims.y);
-					generateSDF(sdf, shape, projection, range, generatorConfig);
+					if(mode != settings.EdgeColoringMode)
+						candidates.Add({mode, (int64)settings.EdgeColoringSeed + i});
+				}
+			}
+		}
 
-					uint8* pixelData = (uint8*)malloc(msdfDims.x * msdfDims.y);
-					ExtractSDFData(sdf, invertDistance, pixelData);
+		TArray<SharedShape> shapes;
+		shapes.SetNum(candidates.Num());
+		const double angleThreshold = FMath::DegreesToRadians(settings.MaxCornerAngle);
+		ParallelFor(candidates.Num(), [&](int32 i)
+		{
+			Shape coloredShape = shape;
+			DoEdgeColoring(coloredShape, candidates[i].Mode, angleThreshold, candidates[i].Seed);
+			shapes[i] = SharedShape(MoveTemp(coloredShape));
+		});
 
-					outTexture->Source.Init(msdfDims.x, msdfDims.y, 1, 1, TSF_G8, pixelData);
-					free(pixelData);
-				}
-				break;
-			
-			case ERTMSDFFormat::SingleChannelPseudo:
-				{
-					Bitmap<float, 1> psdf(msdfDims.x, msdfDims.y);
-					generatePseudoSDF(psdf, shape, projection, range, generatorConfig);
-					uint8* pixelData = (uint8*)malloc(msdfDims.x * msdfDims.y);
-					ExtractSDFData(psdf, invertDistance, pixelData);
+		// Previews are plain MSDFs - the true distance alpha of an MTSDF does not depend on the coloring
+		const Vector2 scale = (double)settings.EdgeColoringPreviewSize / min(svgDims.x, svgDims.y);
+		const Projection projection(scale, 0.0);
+		const int32 width = FMath::Max(1, (int32)(svgDims.x * scale.x));
+		const int32 height = FMath::Max(1, (int32)(svgDims.y * scale.y));
+		const int32 stencilWords = ErrorCorrectionConfig::bufferSize(width, height) / sizeof(uint64);
 
-					outTexture->Source.Init(msdfDims.x, msdfDims.y, 1, 1, TSF_G8, pixelData);
-					free(pixelData);
-				}
-				break;
+		// Error correction leaves the stencils untouched when it is disabled, so they are zeroed to count no corrected texels then
+		TArray<float> pixels;
+		TArray<uint64> stencils;
+		TArray<GeneratorJob> jobs;
+		pixels.SetNumUninitialized(candidates.Num() * width * height * 3);
+		stencils.SetNumZeroed(candidates.Num() * stencilWords);
+		jobs.SetNum(candidates.Num());
+		for(int32 i = 0; i < candidates.Num(); i++)
+		{
+			GeneratorJob& job = jobs[i];
+			job.type = GENERATE_MSDF;
+			job.shape = shapes[i];
+			job.projection = projection;
+			job.range = range;
+			job.config = generatorConfig;
+			job.config.errorCorrection.buffer = reinterpret_cast<byte*>(stencils.GetData() + i * stencilWords);
+			job.config.errorCorrection.nearestEdgeBuffer = nullptr;
+			job.pixels = pixels.GetData() + i * width * height * 3;
+			job.width = width;
+			job.height = height;
+		}
+		generateBatch(jobs.GetData(), jobs.Num());
 
-			case ERTMSDFFormat::Multichannel:
-				{
-					Bitmap<float, 3> msdf(msdfDims.x, msdfDims.y);
-					generateMSDF(msdf, shape, projection, range, generatorConfig);
+		ParallelFor(candidates.Num(), [&](int32 i)
+		{
+			const GeneratorJob& job = jobs[i];
+			const double areaError = estimateSDFError(BitmapConstRef<float, 3>(job.pixels, width, height), *shapes[i], projection, EdgeColoringScanlinesPerRow, FILL_NONZERO);
+			const int32 correctedTexels = job.config.errorCorrection.mode != ErrorCorrectionConfig::DISABLED ? ErrorCorrectionConfig::countErrors(job.config.errorCorrection.buffer, width, height) : 0;
+			candidates[i].Score = areaError + CorrectedTexelPenalty * correctedTexels / (width * height);
+		});
+
+		int32 best = 0;
+		for(int32 i = 1; i < candidates.Num(); i++)
+		{
+			if(candidates[i].Score < candidates[best].Score)
+				best = i;
+		}
 
-					uint8* pixelData = (uint8*)malloc(msdfDims.x * msdfDims.y * 4);
-					ExtractSDFData(msdf, invertDistance, pixelData);
+		UE_LOG(RTMSDFEditor, Log, TEXT("Scored %d edge colorings at %dx%d in %.2f milliseconds - picked %s seed %lld (score %f, previous %f)"), candidates.Num(), width, height, (FPlatformTime::Seconds() - startTime) * 1000.0,
+			*UEnum::GetValueAsString(candidates[best].Mode), candidates[best].Seed, candidates[best].Score, candidates[0].Score);
+		return candidates[best];
+	}
 
-					outTexture->Source.Init(msdfDims.x, msdfDims.y, 1, 1, TSF_BGRA8, pixelData);
-					free(pixelData);
-				}
-				break;
+	void Generate(ERTMSDFFormat format, const MSDFGeneratorConfig& generatorConfig, const Vector2& msdfDims, const SharedShape& shape, const Projection& projection, double range, bool invertDistance, UTexture2D* outTexture)
+	{
+		FRTMSDFGenerationJob job;
+		job.Format = format;
+		job.GeneratorConfig = &generatorConfig;
+		job.Shape = shape;
+		job.Projection = &projection;
+		job.Width = (int32)msdfDims.x;
+		job.Height = (int32)msdfDims.y;
+		job.Range = range;
+		job.InvertDistance = invertDistance;
+		job.OutTexture = outTexture;
+		GenerateBatch(MakeArrayView(&job, 1));
+	}
 
-			case ERTMSDFFormat::MultichannelPlusAlpha:
-				{
-					Bitmap<float, 4> mtsdf(msdfDims.x, msdfDims.y);
-					generateMTSDF(mtsdf, shape, projection, range, generatorConfig);
-					uint8* pixelData = (uint8*)malloc(msdfDims.x * msdfDims.y * 4);
-					ExtractSDFData(mtsdf, invertDistance, pixelData);
+	void GenerateBatch(TArrayView<const FRTMSDFGenerationJob> jobs)
+	{
+		TArray<TArray<float>> floatPixels;
+		TArray<TArray<int32>> nearestEdges;
+		TArray<GeneratorJob> generatorJobs;
+		floatPixels.SetNum(jobs.Num());
+		nearestEdges.SetNum(jobs.Num());
+		generatorJobs.SetNum(jobs.Num());
 
-					outTexture->Source.Init(msdfDims.x, msdfDims.y, 1, 1, TSF_BGRA8, pixelData);
-					free(pixelData);
-				}
-				break;
-			default: ;
+		// Error correction stencils for the whole batch come out of a single arena, offsets are resolved once it has been sized
+		TArray<uint64> stencilArena;
+		TArray<int32> stencilOffsets;
+		stencilOffsets.Init(INDEX_NONE, jobs.Num());
+
+		for(int32 i = 0; i < jobs.Num(); i++)
+		{
+			const FRTMSDFGenerationJob& job = jobs[i];
+			GeneratorJob& generatorJob = generatorJobs[i];
+			int32 channels = 1;
+			switch(job.Format)
+			{
+				case ERTMSDFFormat::SingleChannel:
+					generatorJob.type = GENERATE_SDF;
+					break;
+				case ERTMSDFFormat::SingleChannelPseudo:
+					generatorJob.type = GENERATE_PSEUDO_SDF;
+					break;
+				case ERTMSDFFormat::Multichannel:
+					generatorJob.type = GENERATE_MSDF;
+					channels = 3;
+					break;
+				case ERTMSDFFormat::MultichannelPlusAlpha:
+					generatorJob.type = GENERATE_MTSDF;
+					channels = 4;
+					break;
+				default:
+					UE_LOG(RTMSDFEditor, Warning, TEXT("Unknown SDF Format requested - skipping"));
+					continue;
+			}
+
+			floatPixels[i].SetNumUninitialized(job.Width * job.Height * channels);
+			generatorJob.shape = job.Shape;
+			generatorJob.projection = *job.Projection;
+			generatorJob.range = job.Range;
+			generatorJob.config = *job.GeneratorConfig;
+			generatorJob.pixels = floatPixels[i].GetData();
+			generatorJob.width = job.Width;
+			generatorJob.height = job.Height;
+
+			// Let the error correction check distances against the edges the generator found nearby rather than the whole shape
+			ErrorCorrectionConfig& errorCorrection = generatorJob.config.errorCorrection;
+			// The generator does not record them with overlap support, which every unresolved SVG is generated with
+			if(channels > 1 && !generatorJob.config.overlapSupport && errorCorrection.mode != ErrorCorrectionConfig::DISABLED && errorCorrection.distanceCheckMode != ErrorCorrectionConfig::DO_NOT_CHECK_DISTANCE)
+			{
+				nearestEdges[i].SetNumUninitialized(job.Width * job.Height);
+				errorCorrection.nearestEdgeBuffer = nearestEdges[i].GetData();
+			}
+
+			if(channels > 1 && errorCorrection.mode != ErrorCorrectionConfig::DISABLED)
+			{
+				stencilOffsets[i] = stencilArena.Num();
+				stencilArena.AddUninitialized(ErrorCorrectionConfig::bufferSize(job.Width, job.Height) / sizeof(uint64));
+			}
+		}
+
+		for(int32 i = 0; i < jobs.Num(); i++)
+		{
+			if(stencilOffsets[i] != INDEX_NONE)
+				generatorJobs[i].config.errorCorrection.buffer = reinterpret_cast<byte*>(stencilArena.GetData() + stencilOffsets[i]);
+		}
+
+		BatchGeneratorStats stats;
+		generateBatch(generatorJobs.GetData(), generatorJobs.Num(), &stats);
+		UE_LOG(RTMSDFEditor, Log, TEXT("Generated %d SDFs (%lld texels, %d work items) in %.2f milliseconds - %.2f MTexels/s"), stats.jobCount, stats.pixelCount, stats.taskCount, stats.seconds * 1000.0, stats.pixelsPerSecond() / 1000000.0);
+
+		// Texture sources can only be written from this thread, so only the conversion to bytes is spread over workers
+		TArray<TArray<uint8>> bytePixels;
+		bytePixels.SetNum(jobs.Num());
+		ParallelFor(jobs.Num(), [&](int32 i)
+		{
+			const GeneratorJob& generatorJob = generatorJobs[i];
+			if(!generatorJob.pixels)
+				return;
+
+			const bool invertDistance = jobs[i].InvertDistance;
+			const int32 width = generatorJob.width;
+			const int32 height = generatorJob.height;
+			switch(generatorJob.type)
+			{
+				case GENERATE_SDF:
+				case GENERATE_PSEUDO_SDF:
+					{
+						bytePixels[i].SetNumUninitialized(width * height);
+						uint8* pixelData = bytePixels[i].GetData();
+						ExtractSDFData(BitmapConstRef<float, 1>(generatorJob.pixels, width, height), invertDistance, pixelData);
+					}
+					break;
+				case GENERATE_MSDF:
+					{
+						bytePixels[i].SetNumUninitialized(width * height * 4);
+						uint8* pixelData = bytePixels[i].GetData();
+						ExtractSDFData(BitmapConstRef<float, 3>(generatorJob.pixels, width, height), invertDistance, pixelData);
+					}
+					break;
+				case GENERATE_MTSDF:
+					{
+						bytePixels[i].SetNumUninitialized(width * height * 4);
+						uint8* pixelData = bytePixels[i].GetData();
+						ExtractSDFData(BitmapConstRef<float, 4>(generatorJob.pixels, width, height), invertDistance, pixelData);
+					}
+					break;
+				default: ;
+			}
+		});
+
+		for(int32 i = 0; i < jobs.Num(); i++)
+		{
+			const GeneratorJob& generatorJob = generatorJobs[i];
+			if(!generatorJob.pixels)
+				continue;
+
+			if(jobs[i].OutTexture)
+			{
+				const ETextureSourceFormat sourceFormat = generatorJob.type == GENERATE_MSDF || generatorJob.type == GENERATE_MTSDF ? TSF_BGRA8 : TSF_G8;
+				jobs[i].OutTexture->Source.Init(generatorJob.width, generatorJob.height, 1, 1, sourceFormat, bytePixels[i].GetData());
+			}
+			if(jobs[i].OutPixels)
+				*jobs[i].OutPixels = MoveTemp(bytePixels[i]);
 		}
 	}
 
@@ -219,4 +692,19 @@ namespace RTMSDFGenerationHelpers
 		texture->SRGB = false;
 		texture->bFlipGreenChannel = false;
 	}
+
+	// Sprite textures, arrays and font data are kept in packages of their own next to the asset, so they can be referenced like any other asset
+	UObject* FindOrCreateSiblingAsset(UClass* assetClass, const UObject* asset, const FString& name, EObjectFlags flags, bool& outCreated)
+	{
+		const FString packageName = FPackageName::GetLongPackagePath(asset->GetOutermost()->GetName()) / name;
+		outCreated = false;
+		if(UObject* existingAsset = StaticLoadObject(assetClass, nullptr, *(packageName + TEXT(".") + name), nullptr, LOAD_NoWarn | LOAD_Quiet))
+			return existingAsset;
+
+		UPackage* package = CreatePackage(*packageName);
+		UObject* newAsset = NewObject<UObject>(package, assetClass, *name, flags | RF_Public | RF_Standalone);
+		FAssetRegistryModule::AssetCreated(newAsset);
+		outCreated = true;
+		return newAsset;
+	}
 }
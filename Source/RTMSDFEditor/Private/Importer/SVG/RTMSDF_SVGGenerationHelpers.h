@@ -2,13 +2,22 @@
 
 #pragma once
 
+#include "ChlumskyMSDFGen/Public/Core/SharedShape.h"
+#include "Containers/ArrayView.h"
 #include "HAL/Platform.h"
+#include "UObject/ObjectMacros.h"
+#include <vector>
 
 enum class ERTMSDFFormat : uint8;
 enum class ERTMSDFColoringMode : uint8;
 enum class ERTMSDFErrorCorrectionMode : uint8;
 struct FRTMSDFTextureSettingsCache;
+struct FRTMSDF_CommonImportSettings;
+struct FRTMSDF_SVGImportSettings;
+struct FRTMSDFEdgeColoringCache;
 
+class UClass;
+class UObject;
 class UTexture2D;
 
 namespace msdfgen
@@ -17,20 +26,57 @@ namespace msdfgen
 	struct Vector2;
 	struct MSDFGeneratorConfig;
 	struct ErrorCorrectionConfig;
-	class Shape;
+	struct SvgSprite;
 	class Projection;
 }
 
+// A single SDF to be generated by RTMSDFGenerationHelpers::GenerateBatch - all referenced objects must outlive the call
+struct FRTMSDFGenerationJob
+{
+	ERTMSDFFormat Format;
+	const msdfgen::MSDFGeneratorConfig* GeneratorConfig = nullptr;
+	// Jobs rendering the same shape at several sizes can share it without copying
+	msdfgen::SharedShape Shape;
+	const msdfgen::Projection* Projection = nullptr;
+	int32 Width = 0;
+	int32 Height = 0;
+	double Range = 1.0;
+	bool InvertDistance = false;
+	UTexture2D* OutTexture = nullptr;
+	// Receives the texels as they would be written to a texture source (BGRA8 or G8), e.g. to be copied into an atlas
+	TArray<uint8>* OutPixels = nullptr;
+};
+
+// An edge coloring tried by RTMSDFGenerationHelpers::FindBestEdgeColoring
+struct FRTMSDFEdgeColoringCandidate
+{
+	ERTMSDFColoringMode Mode;
+	int64 Seed = 0;
+	// Estimated portion of incorrectly filled area, plus a penalty for texels flattened by error correction - lower is better
+	double Score = 0.0;
+};
+
 namespace RTMSDFGenerationHelpers
 {
-	bool CreateShape(const uint8* buffer, const uint8* bufferEnd, msdfgen::Shape& outShape, msdfgen::Vector2& outSvgDims);
+	bool CreateShape(const uint8* buffer, const uint8* bufferEnd, double arcTolerance, bool resolveElements, msdfgen::Shape& outShape, msdfgen::Vector2& outSvgDims, const FString& sourceName);
+	bool CreateSpriteShapes(const uint8* buffer, const uint8* bufferEnd, double arcTolerance, bool resolveElements, std::vector<msdfgen::SvgSprite>& outSprites, const FString& sourceName);
+	bool PrepareGlyphOutline(msdfgen::Shape& outline, bool resolveGeometry, bool& outResolvedGeometry);
+	double GetDistanceRange(const FRTMSDF_CommonImportSettings& settings, const msdfgen::Vector2& sourceDims, double scale);
+	uint64 HashShapeSource(const uint8* buffer, const uint8* bufferEnd, double arcTolerance, bool resolveElements);
+	bool LoadCachedShape(uint64 sourceHash, msdfgen::Shape& outShape, msdfgen::Vector2& outSvgDims);
+	void SaveCachedShape(uint64 sourceHash, const msdfgen::Shape& shape, const msdfgen::Vector2& svgDims, int64 cacheSizeLimit);
 	void DoEdgeColoring(msdfgen::Shape& shape, ERTMSDFColoringMode mode, double angleThreshold, int64 seed);
+	bool DoEdgeColoring(msdfgen::Shape& shape, ERTMSDFColoringMode mode, double angleThreshold, int64 seed, FRTMSDFEdgeColoringCache& cache);
+	uint64 HashEdgeColoringInputs(const msdfgen::Shape& shape, ERTMSDFColoringMode mode, double angleThreshold, int64 seed);
 	void ApplyErrorCorrectionModeTo(msdfgen::ErrorCorrectionConfig& config, ERTMSDFErrorCorrectionMode mode);
-	void Generate(ERTMSDFFormat format, const msdfgen::MSDFGeneratorConfig& generatorConfig, const msdfgen::Vector2& msdfDims, const msdfgen::Shape& shape, const msdfgen::Projection& projection, double range, bool invertDistance, UTexture2D* outTexture);
+	FRTMSDFEdgeColoringCandidate FindBestEdgeColoring(const msdfgen::Shape& shape, const msdfgen::Vector2& svgDims, const FRTMSDF_SVGImportSettings& settings, const msdfgen::MSDFGeneratorConfig& generatorConfig, double range);
+	void Generate(ERTMSDFFormat format, const msdfgen::MSDFGeneratorConfig& generatorConfig, const msdfgen::Vector2& msdfDims, const msdfgen::SharedShape& shape, const msdfgen::Projection& projection, double range, bool invertDistance, UTexture2D* outTexture);
+	void GenerateBatch(TArrayView<const FRTMSDFGenerationJob> jobs);
 
 	void ExtractSDFData(const msdfgen::BitmapConstRef<float, 3>& msdf, bool invertColor, uint8*& outData);
 	void ExtractSDFData(const msdfgen::BitmapConstRef<float, 4>& msdf, bool invertColor, uint8*& outData);
 	void ExtractSDFData(const msdfgen::BitmapConstRef<float, 1>& msdf, bool invertColor, uint8*& outData);
 
 	void UpdateNewTextureSettings(UTexture2D* texture, const FRTMSDFTextureSettingsCache& cache, ERTMSDFFormat format);
+	UObject* FindOrCreateSiblingAsset(UClass* assetClass, const UObject* asset, const FString& name, EObjectFlags flags, bool& outCreated);
 }
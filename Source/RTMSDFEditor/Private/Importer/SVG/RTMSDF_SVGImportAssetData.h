@@ -3,10 +3,46 @@
 #pragma once
 
 #include "Engine/AssetUserData.h"
+#include "Engine/Texture2D.h"
+#include "Engine/Texture2DArray.h"
 #include "RTMSDF_SVGImportSettings.h"
 
 #include "RTMSDF_SVGImportAssetData.generated.h"
 
+// Edge colors from the last import, reused while the shape geometry and coloring settings are unchanged
+USTRUCT()
+struct FRTMSDFEdgeColoringCache
+{
+	GENERATED_BODY()
+
+	// Hash of the normalized shape geometry, coloring mode, angle threshold and seed the colors were produced from
+	UPROPERTY()
+	uint64 Hash = 0;
+
+	// One msdfgen::EdgeColor per edge, in contour order
+	UPROPERTY()
+	TArray<uint8> EdgeColors;
+};
+
+// A sprite of a sprite sheet import
+USTRUCT()
+struct FRTMSDF_SVGSprite
+{
+	GENERATED_BODY()
+
+	// Id of the SVG element the sprite was read from
+	UPROPERTY(VisibleAnywhere, Category="Sprite")
+	FString Id;
+
+	// The sprite's cell of the atlas, in UVs
+	UPROPERTY(VisibleAnywhere, Category="Sprite")
+	FBox2D UVs = FBox2D(ForceInit);
+
+	// The sprite's own texture, in the Textures and TextureArray sprite sheet modes
+	UPROPERTY(VisibleAnywhere, Category="Sprite")
+	TSoftObjectPtr<UTexture2D> Texture;
+};
+
 UCLASS(meta=(DisplayName="SVG to SDF Import Asset Data [RTMSDF]"))
 class URTMSDF_SVGImportAssetData : public UAssetUserData
 {
@@ -16,5 +52,16 @@ public:
 	UPROPERTY(EditAnywhere, Category="Import", meta=(FullyExpand=true))
 	FRTMSDF_SVGImportSettings ImportSettings;
 
+	UPROPERTY()
+	FRTMSDFEdgeColoringCache EdgeColoringCache;
+
+	// Sprites of the last sprite sheet import, in document order
+	UPROPERTY(VisibleAnywhere, Category="Sprites")
+	TArray<FRTMSDF_SVGSprite> Sprites;
+
+	// Texture array of the sprite textures, in the TextureArray sprite sheet mode
+	UPROPERTY(VisibleAnywhere, Category="Sprites")
+	TSoftObjectPtr<UTexture2DArray> SpriteArray;
+
 	virtual bool IsEditorOnly() const override { return true; }
 };
@@ -63,6 +63,22 @@ enum class ERTMSDFErrorCorrectionMode : uint8
 	IndiscriminateFull UMETA(DisplayName="Indiscriminate - Full"),
 };
 
+UENUM(DisplayName = "SVG Sprite Sheet Mode [RTMSDF]")
+enum class ERTMSDFSpriteSheetMode : uint8
+{
+	// The whole document is imported as a single SDF
+	Disabled,
+
+	// The imported texture becomes an atlas with a square cell per sprite. The UVs of each cell are listed in the texture's import asset data
+	Atlas,
+
+	// As Atlas, plus a texture per sprite next to the atlas, named after it and the sprite's id
+	Textures,
+
+	// As Textures, plus a Texture2DArray of the sprite textures next to the atlas, with a slice per sprite in the order they are listed in the import asset data
+	TextureArray,
+};
+
 USTRUCT(meta=(DisplayName="SVG to SDF Import Settings [RTMSDF]"))
 struct FRTMSDF_SVGImportSettings : public FRTMSDF_CommonImportSettings
 {
@@ -75,6 +91,18 @@ struct FRTMSDF_SVGImportSettings : public FRTMSDF_CommonImportSettings
 	UPROPERTY(EditAnywhere, Category="Import")
 	int TextureSize = 32;
 
+	/* Maximum distance in texels between SVG arcs, circles and ellipses and the curves approximating them. Each arc is split into as few curves as this allows */
+	UPROPERTY(EditAnywhere, Category="Import", meta=(UIMin=0.001, ClampMin=0.001, UIMax=1))
+	float ArcTolerance = 0.05f;
+
+	/* Import every <symbol>, and every group directly inside the root or its <defs>, that has an id as a sprite of its own. The SVG is parsed once and all sprites are generated together, each fitted into a square of TextureSize texels */
+	UPROPERTY(EditAnywhere, Category="Import")
+	ERTMSDFSpriteSheetMode SpriteSheetMode = ERTMSDFSpriteSheetMode::Disabled;
+
+	/* Split intersecting contours and merge overlapping ones before generating, so the SDF can be generated without the slower overlap support. Shapes that can't be resolved (e.g. open paths) fall back to overlap support */
+	UPROPERTY(EditAnywhere, Category="Import")
+	bool ResolveGeometry = true;
+
 	UPROPERTY(EditAnywhere, Category="Import", meta=(EditCondition="Format == ERTMSDFFormat::Multichannel || Format == ERTMSDFFormat::MultichannelPlusAlpha", DisplayAfter="InvertDistance"))
 	ERTMSDFColoringMode EdgeColoringMode = ERTMSDFColoringMode::Distance;
 
@@ -85,6 +113,18 @@ struct FRTMSDF_SVGImportSettings : public FRTMSDF_CommonImportSettings
 	UPROPERTY(EditAnywhere, Category="Import", meta=(EditCondition="Format == ERTMSDFFormat::Multichannel || Format == ERTMSDFFormat::MultichannelPlusAlpha", DisplayAfter="InvertDistance", UIMin=1, ClampMin=1, UIMax=179, ClampMax=179))
 	float MaxCornerAngle = 175.0f;
 
+	/* Number of edge coloring seeds to try, counting up from EdgeColoringSeed. Each candidate is scored on a low resolution preview and the best one is written back to EdgeColoringSeed (and EdgeColoringMode). 1 disables the search */
+	UPROPERTY(EditAnywhere, Category="Import", meta=(EditCondition="Format == ERTMSDFFormat::Multichannel || Format == ERTMSDFFormat::MultichannelPlusAlpha", DisplayAfter="InvertDistance", UIMin=1, ClampMin=1, UIMax=64))
+	int EdgeColoringCandidates = 1;
+
+	/* Also try every other edge coloring mode with each candidate seed */
+	UPROPERTY(EditAnywhere, Category="Import", meta=(EditCondition="(Format == ERTMSDFFormat::Multichannel || Format == ERTMSDFFormat::MultichannelPlusAlpha) && EdgeColoringCandidates > 1", DisplayAfter="InvertDistance"))
+	bool SearchEdgeColoringModes = false;
+
+	/* Size of the shortest edge of the previews used to score edge coloring candidates */
+	UPROPERTY(EditAnywhere, Category="Import", meta=(EditCondition="(Format == ERTMSDFFormat::Multichannel || Format == ERTMSDFFormat::MultichannelPlusAlpha) && EdgeColoringCandidates > 1", DisplayAfter="InvertDistance", UIMin=8, ClampMin=8, UIMax=512))
+	int EdgeColoringPreviewSize = 64;
+
 	UPROPERTY(EditAnywhere, Category="Import", meta=(EditCondition="Format == ERTMSDFFormat::Multichannel || Format == ERTMSDFFormat::MultichannelPlusAlpha", DisplayAfter="InvertDistance"))
 	ERTMSDFErrorCorrectionMode ErrorCorrectionMode = ERTMSDFErrorCorrectionMode::EdgePriorityFull;
 
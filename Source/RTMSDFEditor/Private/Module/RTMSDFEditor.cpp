@@ -5,6 +5,7 @@
 #include "Engine/Texture2D.h"
 #include "ISettingsModule.h"
 #include "ISettingsSection.h"
+#include "Importer/Font/RTMSDF_FontFactory.h"
 #include "Modules/ModuleManager.h"
 #include "PropertyEditorModule.h"
 #include "RTMSDFEditor.h"
@@ -39,7 +40,7 @@ void FRTMSDFEditorModule::StartupModule()
 	{
 		ISettingsSectionPtr settingsSection = settingsModule->RegisterSettings("Project", "Plugins", "RTM SDF",
 			LOCTEXT("SettingsName", "RTM SDF"),
-			LOCTEXT("SettingsDescription", "Configure Defaults for newly imported .svg to SDF Textures"),
+			LOCTEXT("SettingsDescription", "Configure Defaults for newly imported .svg and font to SDF Textures"),
 			GetMutableDefault<URTMSDFConfig>());
 	}
 
@@ -49,6 +50,12 @@ void FRTMSDFEditorModule::StartupModule()
 
 	RTMSDF::RegisterStructDetailsCustomization<FRTMSDF_SettingsStructCustomization, FRTMSDF_SVGImportSettings>();
 	RTMSDF::RegisterStructDetailsCustomization<FRTMSDF_SettingsStructCustomization, FRTMSDF_BitmapImportSettings>();
+	RTMSDF::RegisterStructDetailsCustomization<FRTMSDF_SettingsStructCustomization, FRTMSDF_FontImportSettings>();
+}
+
+void FRTMSDFEditorModule::ShutdownModule()
+{
+	URTMSDF_FontFactory::ReleaseLoadedFont();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -11,4 +11,5 @@ class FRTMSDFEditorModule : public IModuleInterface
 {
 protected:
 	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
 };
@@ -0,0 +1,55 @@
+﻿// Copyright (c) Richard Meredith AB. All Rights Reserved
+
+#include "ChlumskyMSDFGen/Public/Core/Shape.h"
+#include "Importer/SVG/RTMSDF_SVGGenerationHelpers.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+using namespace msdfgen;
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRTMSDFSelfCrossingGlyphTest, "RTMSDF.Font.SelfCrossingGlyph", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FRTMSDFSelfCrossingGlyphTest::RunTest(const FString& parameters)
+{
+	// A figure-eight of quadratics as FreeType decomposes TrueType outlines, crossing itself where its edges meet.
+	// Its lobes are wound in opposite directions, so its signed area is zero although both are filled
+	const auto makeOutline = []
+	{
+		Shape outline;
+		Contour& contour = outline.addContour();
+		contour.addEdge(EdgeHolder(Point2(0, 50), Point2(0, 100), Point2(50, 50)));
+		contour.addEdge(EdgeHolder(Point2(50, 50), Point2(100, 0), Point2(100, 50)));
+		contour.addEdge(EdgeHolder(Point2(100, 50), Point2(100, 100), Point2(50, 50)));
+		contour.addEdge(EdgeHolder(Point2(50, 50), Point2(0, 0), Point2(0, 50)));
+		return outline;
+	};
+	const Point2 lobePoints[] = {Point2(20, 60), Point2(80, 40)};
+
+	for(const bool resolveGeometry : {true, false})
+	{
+		Shape outline = makeOutline();
+		bool resolvedGeometry = false;
+		const FString mode = resolveGeometry ? TEXT("resolved") : TEXT("oriented");
+		if(!TestTrue(FString::Printf(TEXT("Outline kept when %s"), *mode), RTMSDFGenerationHelpers::PrepareGlyphOutline(outline, resolveGeometry, resolvedGeometry)))
+			continue;
+		TestEqual(FString::Printf(TEXT("Geometry %s"), *mode), (int32)resolvedGeometry, (int32)resolveGeometry);
+
+		for(const Point2& point : lobePoints)
+		{
+			Scanline scanline;
+			outline.scanline(scanline, point.y);
+			TestTrue(FString::Printf(TEXT("Lobe at %.0f,%.0f filled when %s"), point.x, point.y, *mode), scanline.filled(point.x, FILL_NONZERO));
+		}
+
+		// Without overlap support, the sign of the distance comes from the nearest edge, so every contour has to wind positively
+		if(resolvedGeometry)
+		{
+			for(const Contour& contour : outline.contours)
+				TestEqual(TEXT("Winding of resolved contour"), contour.winding(), 1);
+		}
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,74 @@
+﻿// Copyright (c) Richard Meredith AB. All Rights Reserved
+
+#include "ChlumskyMSDFGen/Public/Core/Shape.h"
+#include "ChlumskyMSDFGen/Public/Ext/import-svg.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+using namespace msdfgen;
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRTMSDFSegmentTypeTest, "RTMSDF.Shape.SegmentTypes", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FRTMSDFSegmentTypeTest::RunTest(const FString& parameters)
+{
+	// normalize and the shape serializers cast segments by their type, so each has to report its own
+	const EdgeHolder linear(Point2(0, 0), Point2(10, 0));
+	const EdgeHolder quadratic(Point2(0, 0), Point2(10, 0), Point2(10, 10));
+	const EdgeHolder cubic(Point2(0, 0), Point2(5, 0), Point2(10, 5), Point2(10, 10));
+	TestEqual(TEXT("Linear segment type"), (int32)linear->type, (int32)EdgeSegment::SegmentType::Linear);
+	TestEqual(TEXT("Quadratic segment type"), (int32)quadratic->type, (int32)EdgeSegment::SegmentType::Quadratic);
+	TestEqual(TEXT("Cubic segment type"), (int32)cubic->type, (int32)EdgeSegment::SegmentType::Cubic);
+
+	// Two quadratics meeting in a cusp are converted to cubics to deconverge them, keeping their end points
+	Shape shape;
+	Contour& contour = shape.addContour();
+	contour.addEdge(EdgeHolder(Point2(0, 0), Point2(10, 0), Point2(10, 10)));
+	contour.addEdge(EdgeHolder(Point2(10, 10), Point2(10, 0), Point2(20, 0)));
+	contour.addEdge(EdgeHolder(Point2(20, 0), Point2(0, 0)));
+	shape.normalize();
+
+	const Point2 ends[] = {Point2(0, 0), Point2(10, 10), Point2(20, 0)};
+	const std::vector<EdgeHolder>& edges = shape.contours[0].edges;
+	if(!TestEqual(TEXT("Edge count after normalize"), (int32)edges.size(), 3))
+		return false;
+	for(int32 i = 0; i < 2; i++)
+	{
+		TestEqual(FString::Printf(TEXT("Type of deconverged edge %d"), i), (int32)edges[i]->type, (int32)EdgeSegment::SegmentType::Cubic);
+		TestTrue(FString::Printf(TEXT("End points of deconverged edge %d"), i), edges[i]->point(0) == ends[i] && edges[i]->point(1) == ends[i + 1]);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRTMSDFZeroAreaContourTest, "RTMSDF.Shape.ZeroAreaContours", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FRTMSDFZeroAreaContourTest::RunTest(const FString& parameters)
+{
+	struct FCase
+	{
+		const TCHAR* Name;
+		const char* Path;
+		int32 ContoursLeft;
+	};
+
+	// Self-crossing contours have zero signed area when their lobes cancel out, but still enclose area
+	const FCase cases[] = {
+		{TEXT("Bowtie"), "M10 10L90 90L90 10L10 90z", 1},
+		{TEXT("Figure-eight cubic"), "M0 0C100 100 100 -100 0 0z", 1},
+		{TEXT("Retraced polyline"), "M0 0L10 10L20 0L10 10z", 0},
+		{TEXT("Retraced curve"), "M0 0Q5 5 10 0L20 0L10 0Q5 5 0 0z", 0},
+	};
+	for(const FCase& test : cases)
+	{
+		// Same order as the importers - normalize splits single edge contours and deconverges the turns of retraced ones first
+		Shape shape;
+		if(!TestTrue(FString::Printf(TEXT("%s parsed"), test.Name), buildShapeFromSvgPath(shape, test.Path)))
+			continue;
+		shape.normalize();
+		shape.removeZeroAreaContours();
+		TestEqual(FString::Printf(TEXT("%s contours left"), test.Name), (int32)shape.contours.size(), test.ContoursLeft);
+	}
+	return true;
+}
+
+#endif
@@ -21,7 +21,9 @@ public class RTMSDFEditor : ModuleRules
 			new string[]
 			{
 				"UnrealEd",
+				"AssetRegistry",
 				"RHI",
+				"RTMSDF",
 				"ChlumskyMSDFGen",
 				"PropertyEditor",
 			});